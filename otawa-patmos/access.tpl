@@ -0,0 +1,42 @@
+/* Generated by gliss-attr ($(date)) copyright (c) 2009 IRIT - UPS */
+
+#include <$(proc)/api.h>
+#include <$(proc)/id.h>
+#include <$(proc)/macros.h>
+
+typedef unsigned long (*access_fun_t)($(proc)_inst_t *inst);
+
+
+
+static unsigned long otawa_access_UNKNOWN($(proc)_inst_t *inst)
+{
+        /* this code should also be used as default value if
+        an instruction has no otawa_access field */
+        return 0;
+}
+
+$(foreach instructions)
+static unsigned long otawa_access_$(IDENT)($(proc)_inst_t *inst) {
+$(otawa_access)
+};
+
+$(end)
+
+
+/* function table */
+static access_fun_t $(proc)_access_table[] =
+{
+	otawa_access_UNKNOWN$(foreach instructions),
+	otawa_access_$(IDENT)$(end)
+};
+
+
+
+/**
+ * Get the memory access class of the instruction.
+ * @return Access class and size.
+ */
+unsigned long $(proc)_access($(proc)_inst_t *inst)
+{
+        return $(proc)_access_table[inst->ident](inst);
+}
@@ -10,10 +10,19 @@
 #include <otawa/proc/Processor.h>
 #include <otawa/util/FlowFactLoader.h>
 #include <elm/genstruct/SortedSLList.h>
+#include <elm/string/StringBuffer.h>
+#include <elm/genstruct/HashTable.h>
 #include <otawa/sim/features.h>
 #include <otawa/prop/Identifier.h>
 #include "patmos.h"
 
+#include <algorithm>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
 
 extern "C"
 {
@@ -30,6 +39,12 @@ extern "C"
 
 #include "otawa_delayed.h"
 
+/* stack cache control */
+#include "otawa_stack.h"
+
+/* memory access class */
+#include "otawa_access.h"
+
 /* instruction kind */
 #include "otawa_kind.h"
 
@@ -95,16 +110,835 @@ public:
         map[PATMOS_REG_MCB] = &regMCB;
         //map[PATMOS_REG_PC]  = &regPC;
         //map[PATMOS_REG_NPC] = &regNPC;
+
+        // build the register mask bits
+        for(int i = 0; i < PATMOS_REG_COUNT; i++)
+            bits[i] = -1;
+        for(int i = 0; i < 32; i++)
+            bits[PATMOS_REG_R(i)] = REG_MASK_R + i;
+        for(int i = 0; i < 16; i++)
+            bits[PATMOS_REG_S(i)] = REG_MASK_S + i;
+        for(int i = 0; i < 8; i++)
+            bits[PATMOS_REG_P(i)] = REG_MASK_P + i;
+        bits[PATMOS_REG_MCB] = REG_MASK_MCB;
+        for(int i = 0; i < PATMOS_REG_COUNT; i++)
+            if(bits[i] >= 0)
+                regs[bits[i]] = map[i];
     }
 
     inline hard::Register *operator[](int i) const { return map[i]; }
+    inline int bit(int i) const { return bits[i]; }
+    inline hard::Register *maskRegister(int bit) const
+        { return 0 <= bit && bit < REG_MASK_SIZE ? regs[bit] : 0; }
+
+    /**
+     * Get the mask bit of a register.
+     * @param reg	Register to look for.
+     * @return		Matching bit or -1 if the register is not in the masks.
+     */
+    int maskBit(const hard::Register *reg) const {
+        if(reg->bank() == &regR)
+            return REG_MASK_R + reg->number();
+        else if(reg->bank() == &regS)
+            return REG_MASK_S + reg->number();
+        else if(reg->bank() == &regP)
+            return REG_MASK_P + reg->number();
+        else if(reg == &regMCB)
+            return REG_MASK_MCB;
+        else
+            return -1;
+    }
+
+    /**
+     * Fill a register array from a register mask.
+     * @param mask	Register mask.
+     * @param tab	Array to fill (must contain at least as many entries as set bits).
+     */
+    void toArray(reg_mask_t mask, hard::Register **tab) const {
+        for(int i = 0; mask; i++, mask &= mask - 1)
+            tab[i] = regs[__builtin_ctzll(mask)];
+    }
+
+    /**
+     * Compute the masks of read and written registers of an instruction.
+     * @param inst	Decoded instruction.
+     * @param rd	Mask of read registers.
+     * @param wr	Mask of written registers.
+     */
+    void masks(patmos_inst_t *inst, reg_mask_t& rd, reg_mask_t& wr) const {
+        rd = 0;
+        wr = 0;
+        if(inst->ident == PATMOS_UNKNOWN)
+            return;
+        patmos_used_regs_read_t rds;
+        patmos_used_regs_write_t wrs;
+        patmos_used_regs(inst, rds, wrs);
+        for(int i = 0; rds[i] != -1; i++)
+            if(bits[rds[i]] >= 0)
+                rd |= reg_mask_t(1) << bits[rds[i]];
+        for(int i = 0; wrs[i] != -1; i++)
+            if(bits[wrs[i]] >= 0)
+                wr |= reg_mask_t(1) << bits[wrs[i]];
+    }
 
 private:
     hard::Register *map[PATMOS_REG_COUNT];
+    int bits[PATMOS_REG_COUNT];
+    hard::Register *regs[REG_MASK_SIZE];
 };
 static RegisterDecoder register_decoder; 
 
 
+/**
+ * Cache of decoded instructions, indexed by address.
+ * The cache is direct-mapped and its size is fixed at creation:
+ * a decoded instruction stays alive until its entry is reused
+ * by an instruction with the same index. The returned instructions
+ * must not be freed by the caller and are only valid until
+ * the next call to get().
+ */
+class DecodeCache {
+public:
+
+	/**
+	 * Build the cache.
+	 * @param decoder	GLISS decoder to use.
+	 * @param size		Number of entries (rounded to the upper power of 2).
+	 */
+	DecodeCache(patmos_decoder_t *decoder, int size): _decoder(decoder), _hits(0), _misses(0) {
+		_size = 1;
+		while(_size < size)
+			_size <<= 1;
+		_entries = new entry_t[_size];
+		for(int i = 0; i < _size; i++) {
+			_entries[i].addr = 0;
+			_entries[i].inst = 0;
+		}
+	}
+
+	~DecodeCache(void) {
+		for(int i = 0; i < _size; i++)
+			if(_entries[i].inst)
+				patmos_free_inst(_entries[i].inst);
+		delete [] _entries;
+	}
+
+	/**
+	 * Get the decoded instruction at the given address.
+	 * @param addr	Address of the instruction.
+	 * @return		Decoded instruction (owned by the cache).
+	 */
+	patmos_inst_t *get(patmos_address_t addr) {
+		entry_t& e = _entries[(addr >> 2) & (_size - 1)];
+		if(e.inst && e.addr == addr) {
+			_hits++;
+			return e.inst;
+		}
+		_misses++;
+		if(e.inst)
+			patmos_free_inst(e.inst);
+		e.addr = addr;
+		e.inst = patmos_decode(_decoder, addr);
+		return e.inst;
+	}
+
+	inline int size(void) const { return _size; }
+	inline t::uint64 hits(void) const { return _hits; }
+	inline t::uint64 misses(void) const { return _misses; }
+
+private:
+	typedef struct {
+		patmos_address_t addr;
+		patmos_inst_t *inst;
+	} entry_t;
+
+	patmos_decoder_t *_decoder;
+	entry_t *_entries;
+	int _size;
+	t::uint64 _hits, _misses;
+};
+
+
+/**
+ * ELF image mapped in memory. The file is mapped once and the sections,
+ * the symbols and the memory content are read directly from the mapping.
+ * Only 32-bit ELF files are supported.
+ */
+class ElfImage {
+public:
+
+	/**
+	 * Loaded section (occupying memory at run time).
+	 */
+	typedef struct {
+		t::uint32 addr, size;
+		const t::uint8 *data;	// null for NOBITS
+	} loaded_t;
+
+	/**
+	 * Map the given file.
+	 * @param path	Path of the ELF file.
+	 * @throw LoadException	If the file cannot be mapped or is not a supported ELF.
+	 */
+	ElfImage(cstring path): base(0), size(0), syms(0), symnum(0), symstr(0), symstr_size(0), loaded(0), lcnt(0), last(0) {
+
+		// map the file
+		int fd = ::open(&path, O_RDONLY);
+		if(fd < 0)
+			throw LoadException(_ << "cannot open \"" << path << "\".");
+		struct stat st;
+		if(fstat(fd, &st) < 0) {
+			::close(fd);
+			throw LoadException(_ << "cannot stat \"" << path << "\".");
+		}
+		size = st.st_size;
+		void *p = mmap(0, size, PROT_READ, MAP_PRIVATE, fd, 0);
+		::close(fd);
+		if(p == MAP_FAILED)
+			throw LoadException(_ << "cannot map \"" << path << "\".");
+		base = static_cast<const t::uint8 *>(p);
+
+		// check the header
+		if(size < sizeof(Elf32_Ehdr)
+		|| base[EI_MAG0] != ELFMAG0 || base[EI_MAG1] != ELFMAG1
+		|| base[EI_MAG2] != ELFMAG2 || base[EI_MAG3] != ELFMAG3
+		|| base[EI_CLASS] != ELFCLASS32) {
+			munmap((void *)base, size);
+			throw LoadException(_ << "\"" << path << "\" is not a 32-bit ELF file.");
+		}
+		big = base[EI_DATA] == ELFDATA2MSB;
+		const Elf32_Ehdr *h = reinterpret_cast<const Elf32_Ehdr *>(base);
+		_entry = fix(h->e_entry);
+		shnum = fix(h->e_shnum);
+		if(!inside(fix(h->e_shoff), shnum * sizeof(Elf32_Shdr)) || fix(h->e_shstrndx) >= shnum)
+			corrupted(path);
+		shdrs = reinterpret_cast<const Elf32_Shdr *>(base + fix(h->e_shoff));
+
+		// check the sections
+		for(int i = 0; i < shnum; i++)
+			if(sectionType(i) != SHT_NOBITS && !inside(fix(shdrs[i].sh_offset), sectionSize(i)))
+				corrupted(path);
+		int shstrndx = fix(h->e_shstrndx);
+		if(!isStringTable(shstrndx))
+			corrupted(path);
+		shstr = reinterpret_cast<const char *>(sectionData(shstrndx));
+		for(int i = 0; i < shnum; i++)
+			if(fix(shdrs[i].sh_name) >= sectionSize(shstrndx))
+				corrupted(path);
+
+		// record the loaded sections and the symbol table
+		loaded = new loaded_t[shnum];
+		for(int i = 0; i < shnum; i++) {
+			if(sectionFlags(i) & SHF_ALLOC) {
+				loaded[lcnt].addr = sectionAddress(i);
+				loaded[lcnt].size = sectionSize(i);
+				loaded[lcnt].data = sectionType(i) == SHT_NOBITS ? 0 : sectionData(i);
+				lcnt++;
+			}
+			if(sectionType(i) == SHT_SYMTAB && !syms) {
+				int link = fix(shdrs[i].sh_link);
+				if(link >= shnum || !isStringTable(link))
+					corrupted(path);
+				syms = reinterpret_cast<const Elf32_Sym *>(sectionData(i));
+				symnum = sectionSize(i) / sizeof(Elf32_Sym);
+				symstr = reinterpret_cast<const char *>(sectionData(link));
+				symstr_size = sectionSize(link);
+			}
+		}
+	}
+
+	~ElfImage(void) {
+		delete [] loaded;
+		munmap((void *)base, size);
+	}
+
+	inline t::uint32 entry(void) const { return _entry; }
+
+	// section access
+	inline int sectionCount(void) const { return shnum; }
+	inline cstring sectionName(int i) const { return shstr + fix(shdrs[i].sh_name); }
+	inline t::uint32 sectionAddress(int i) const { return fix(shdrs[i].sh_addr); }
+	inline t::uint32 sectionSize(int i) const { return fix(shdrs[i].sh_size); }
+	inline t::uint32 sectionFlags(int i) const { return fix(shdrs[i].sh_flags); }
+	inline t::uint32 sectionType(int i) const { return fix(shdrs[i].sh_type); }
+	inline const t::uint8 *sectionData(int i) const { return base + fix(shdrs[i].sh_offset); }
+
+	// symbol access
+	inline int symbolCount(void) const { return symnum; }
+	inline cstring symbolName(int i) const
+		{ t::uint32 n = fix(syms[i].st_name); return n < symstr_size ? symstr + n : ""; }
+	inline t::uint32 symbolValue(int i) const { return fix(syms[i].st_value); }
+	inline t::uint32 symbolSize(int i) const { return fix(syms[i].st_size); }
+	inline int symbolType(int i) const { return ELF32_ST_TYPE(syms[i].st_info); }
+
+	/**
+	 * Find the loaded section containing the given range.
+	 * @param addr	Range address.
+	 * @param n		Range size.
+	 * @return		Found loaded section or null.
+	 */
+	const loaded_t *find(t::uint32 addr, t::uint32 n) const {
+		if(last && last->addr <= addr && addr + n <= last->addr + last->size)
+			return last;
+		for(int i = 0; i < lcnt; i++)
+			if(loaded[i].addr <= addr && addr + n <= loaded[i].addr + loaded[i].size) {
+				last = &loaded[i];
+				return last;
+			}
+		return 0;
+	}
+
+	/**
+	 * Read an integer in the target endianness.
+	 * @param addr	Address to read from.
+	 * @param n		Size of the integer (1, 2, 4 or 8).
+	 * @return		Read value (0 outside the loaded sections).
+	 */
+	t::uint64 read(t::uint32 addr, int n) const {
+		const loaded_t *l = find(addr, n);
+		if(!l || !l->data)
+			return 0;
+		const t::uint8 *p = l->data + (addr - l->addr);
+		t::uint64 v = 0;
+		if(big)
+			for(int i = 0; i < n; i++)
+				v = (v << 8) | p[i];
+		else
+			for(int i = n - 1; i >= 0; i--)
+				v = (v << 8) | p[i];
+		return v;
+	}
+
+	/**
+	 * Get the contiguous bytes of the mapping starting at the given address.
+	 * @param addr	Start address.
+	 * @param avail	Set to the number of available bytes.
+	 * @return		Pointer to the bytes or null if the address is not
+	 * 				in a section with content.
+	 */
+	const t::uint8 *span(t::uint32 addr, t::uint32& avail) const {
+		const loaded_t *l = find(addr, 1);
+		if(!l || !l->data) {
+			avail = 0;
+			return 0;
+		}
+		avail = l->addr + l->size - addr;
+		return l->data + (addr - l->addr);
+	}
+
+	/**
+	 * Copy a block of memory, possibly spanning several sections.
+	 * @param addr	Address of the block.
+	 * @param buf	Buffer to copy to.
+	 * @param n		Size of the block.
+	 */
+	void read(t::uint32 addr, char *buf, int n) const {
+		while(n > 0) {
+			t::uint32 avail;
+			const t::uint8 *p = span(addr, avail);
+			if(!p) {
+				*buf++ = 0;
+				addr++;
+				n--;
+			}
+			else {
+				int m = min(t::uint32(n), avail);
+				memcpy(buf, p, m);
+				buf += m;
+				addr += m;
+				n -= m;
+			}
+		}
+	}
+
+	inline bool isBigEndian(void) const { return big; }
+	inline t::uint32 fix(t::uint32 v) const { return big ? __builtin_bswap32(v) : v; }
+	inline t::uint16 fix(t::uint16 v) const { return big ? __builtin_bswap16(v) : v; }
+
+private:
+
+	/**
+	 * Test if a range of the file is inside the mapping.
+	 * @param off	Range offset.
+	 * @param n		Range size.
+	 */
+	inline bool inside(t::uint32 off, t::uint32 n) const
+		{ return off <= size && n <= size - off; }
+
+	/**
+	 * Test if a section is a non-empty string table ended by a null character,
+	 * so that any index inside the section gives a valid C string.
+	 * @param i		Section index.
+	 */
+	inline bool isStringTable(int i) const {
+		return sectionType(i) == SHT_STRTAB && sectionSize(i) > 0
+			&& sectionData(i)[sectionSize(i) - 1] == '\0';
+	}
+
+	/**
+	 * Release the mapping and throw the corruption exception.
+	 * @param path	Path of the ELF file.
+	 */
+	void corrupted(cstring path) {
+		delete [] loaded;
+		munmap((void *)base, size);
+		throw LoadException(_ << "\"" << path << "\" is corrupted.");
+	}
+
+	const t::uint8 *base;
+	size_t size;
+	bool big;
+	t::uint32 _entry;
+	const Elf32_Shdr *shdrs;
+	int shnum;
+	const char *shstr;
+	const Elf32_Sym *syms;
+	int symnum;
+	const char *symstr;
+	t::uint32 symstr_size;
+	loaded_t *loaded;
+	int lcnt;
+	mutable const loaded_t *last;
+};
+
+
+/**
+ * Index of the source line map built from a single traversal of the
+ * DWARF line table. It provides a sorted address interval array for
+ * address to line lookup and, for each file base name, an array of
+ * line to address range entries sorted by line. The lines between two
+ * consecutive entries of a file are not expanded: they are recorded as
+ * line intervals mapped to the address range of the first entry and
+ * resolved by binary search.
+ */
+class LineIndex {
+public:
+	typedef struct {
+		t::uint32 low, high;
+		const char *file;
+		int line;
+	} line_t;
+
+	LineIndex(gel_line_map_t *map): addrs(0), acnt(0) {
+		genstruct::Vector<line_t> all;
+		genstruct::HashTable<String, tmp_t *> tmp;
+
+		// traverse the line table
+		gel_line_iter_t iter;
+		gel_location_t loc, ploc = { 0, 0, 0, 0 };
+		for(loc = gel_first_line(&iter, map); loc.file; loc = gel_next_line(&iter)) {
+			line_t l;
+			l.low = loc.low_addr;
+			l.high = loc.high_addr;
+			l.file = loc.file;
+			l.line = loc.line;
+			all.add(l);
+			tmp_t *v = tmp.get(baseName(loc.file), 0);
+			if(!v) {
+				v = new tmp_t();
+				tmp.put(baseName(loc.file), v);
+			}
+			v->lines.add(l);
+
+			// lines between two consecutive entries map to the first one
+			if(loc.file == ploc.file && ploc.line + 1 < loc.line) {
+				gap_t g;
+				g.first = ploc.line + 1;
+				g.last = loc.line - 1;
+				g.low = ploc.low_addr;
+				g.high = ploc.high_addr;
+				g.file = ploc.file;
+				v->gaps.add(g);
+			}
+			ploc = loc;
+		}
+
+		// build the address index
+		acnt = all.count();
+		addrs = new line_t[acnt];
+		for(int i = 0; i < acnt; i++)
+			addrs[i] = all[i];
+		std::sort(addrs, addrs + acnt, lessAddress);
+
+		// build the file indexes
+		for(genstruct::HashTable<String, tmp_t *>::KeyIterator k(tmp); k; k++) {
+			tmp_t *v = tmp.get(*k, 0);
+			lines_t ls;
+			ls.cnt = v->lines.count();
+			ls.lines = new line_t[ls.cnt];
+			for(int i = 0; i < ls.cnt; i++)
+				ls.lines[i] = v->lines[i];
+			std::sort(ls.lines, ls.lines + ls.cnt, lessLine);
+			ls.gcnt = v->gaps.count();
+			ls.gaps = new gap_t[ls.gcnt];
+			ls.reach = new int[ls.gcnt];
+			for(int i = 0; i < ls.gcnt; i++)
+				ls.gaps[i] = v->gaps[i];
+			std::sort(ls.gaps, ls.gaps + ls.gcnt, lessGap);
+			for(int i = 0; i < ls.gcnt; i++)
+				ls.reach[i] = i == 0 ? ls.gaps[i].last : max(ls.reach[i - 1], ls.gaps[i].last);
+			files.put(*k, ls);
+			delete v;
+		}
+	}
+
+	~LineIndex(void) {
+		delete [] addrs;
+		for(genstruct::HashTable<String, lines_t>::ItemIterator ls(files); ls; ls++) {
+			delete [] (*ls).lines;
+			delete [] (*ls).gaps;
+			delete [] (*ls).reach;
+		}
+	}
+
+	/**
+	 * Find the line entry containing the given address.
+	 * @param addr	Looked address.
+	 * @return		Found entry or null.
+	 */
+	const line_t *find(t::uint32 addr) const {
+		int l = 0, h = acnt;
+		while(l < h) {
+			int m = (l + h) / 2;
+			if(addrs[m].low <= addr)
+				l = m + 1;
+			else
+				h = m;
+		}
+		if(l > 0 && addr < addrs[l - 1].high)
+			return &addrs[l - 1];
+		return 0;
+	}
+
+	/**
+	 * Find the address ranges of a source line.
+	 * @param file		File path (possibly a suffix of the actual path).
+	 * @param line		Line number.
+	 * @param addresses	Vector to store found address ranges in.
+	 */
+	void find(cstring file, int line, Vector<Pair<Address, Address> >& addresses) const {
+		String base = baseName(file);
+		Option<lines_t> ls = files.get(base);
+		if(ls)
+			find(*ls, file, line, addresses);
+
+		// the given path may end in the middle of a base name
+		else
+			for(genstruct::HashTable<String, lines_t>::KeyIterator k(files); k; k++)
+				if((*k).endsWith(base))
+					find(*files.get(*k), file, line, addresses);
+	}
+
+private:
+	typedef struct {
+		int first, last;
+		t::uint32 low, high;
+		const char *file;
+	} gap_t;
+
+	typedef struct {
+		genstruct::Vector<line_t> lines;
+		genstruct::Vector<gap_t> gaps;
+	} tmp_t;
+
+	typedef struct {
+		line_t *lines;
+		int cnt;
+		gap_t *gaps;	// sorted by first line
+		int *reach;		// greatest last line of the gaps up to the index
+		int gcnt;
+	} lines_t;
+
+	void find(const lines_t& ls, cstring file, int line, Vector<Pair<Address, Address> >& addresses) const {
+
+		// lines of the table
+		int l = 0, h = ls.cnt;
+		while(l < h) {
+			int m = (l + h) / 2;
+			if(ls.lines[m].line < line)
+				l = m + 1;
+			else
+				h = m;
+		}
+		for(; l < ls.cnt && ls.lines[l].line == line; l++)
+			if(file == ls.lines[l].file || cstring(ls.lines[l].file).endsWith(file))
+				addresses.add(pair(Address(ls.lines[l].low), Address(ls.lines[l].high)));
+
+		// gaps containing the line: starting before it and reaching it
+		l = 0;
+		h = ls.gcnt;
+		while(l < h) {
+			int m = (l + h) / 2;
+			if(ls.gaps[m].first <= line)
+				l = m + 1;
+			else
+				h = m;
+		}
+		for(int i = l - 1; i >= 0 && ls.reach[i] >= line; i--)
+			if(ls.gaps[i].last >= line
+			&& (file == ls.gaps[i].file || cstring(ls.gaps[i].file).endsWith(file)))
+				addresses.add(pair(Address(ls.gaps[i].low), Address(ls.gaps[i].high)));
+	}
+
+	static String baseName(cstring path) {
+		const char *p = strrchr(&path, '/');
+		return p ? String(p + 1) : String(path);
+	}
+
+	static bool lessAddress(const line_t& l1, const line_t& l2)
+		{ return l1.low < l2.low; }
+	static bool lessLine(const line_t& l1, const line_t& l2)
+		{ return l1.line < l2.line || (l1.line == l2.line && l1.low < l2.low); }
+	static bool lessGap(const gap_t& g1, const gap_t& g2)
+		{ return g1.first < g2.first || (g1.first == g2.first && g1.low < g2.low); }
+
+	line_t *addrs;
+	int acnt;
+	genstruct::HashTable<String, lines_t> files;
+};
+
+
+/**
+ * Index of the symbols sorted by address.
+ */
+class SymbolIndex {
+public:
+	typedef struct {
+		t::uint32 addr, size;
+		Symbol *sym;
+	} entry_t;
+
+	SymbolIndex(void): funs(0), fcnt(0), all(0), acnt(0) { }
+	~SymbolIndex(void) {
+		delete [] funs;
+		delete [] all;
+	}
+
+	/**
+	 * Build the index.
+	 * @param syms	Symbols to index.
+	 */
+	void build(const genstruct::Vector<entry_t>& syms) {
+		acnt = syms.count();
+		all = new entry_t[acnt];
+		fcnt = 0;
+		for(int i = 0; i < acnt; i++) {
+			all[i] = syms[i];
+			if(syms[i].sym->kind() == Symbol::FUNCTION)
+				fcnt++;
+		}
+		funs = new entry_t[fcnt];
+		for(int i = 0, j = 0; i < acnt; i++)
+			if(all[i].sym->kind() == Symbol::FUNCTION)
+				funs[j++] = all[i];
+		std::sort(all, all + acnt, less);
+		std::sort(funs, funs + fcnt, less);
+	}
+
+	/**
+	 * Find the symbol with the greatest address less or equal to the given one.
+	 * @param tab	Sorted entry table.
+	 * @param cnt	Entry count.
+	 * @param addr	Looked address.
+	 * @return		Found entry or null.
+	 */
+	static const entry_t *floor(const entry_t *tab, int cnt, t::uint32 addr) {
+		int l = 0, h = cnt;
+		while(l < h) {
+			int m = (l + h) / 2;
+			if(tab[m].addr <= addr)
+				l = m + 1;
+			else
+				h = m;
+		}
+		return l > 0 ? &tab[l - 1] : 0;
+	}
+
+	inline const entry_t *function(t::uint32 addr) const { return floor(funs, fcnt, addr); }
+	inline const entry_t *symbol(t::uint32 addr) const { return floor(all, acnt, addr); }
+
+private:
+	static bool less(const entry_t& e1, const entry_t& e2)
+		{ return e1.addr < e2.addr; }
+
+	entry_t *funs;
+	int fcnt;
+	entry_t *all;
+	int acnt;
+};
+
+
+/**
+ * Memory arena serving small objects from big slabs. The objects
+ * are never freed individually: the whole memory is released
+ * with the arena.
+ */
+class Arena {
+public:
+	static const int SLAB_SIZE = 64 * 1024;
+
+	Arena(void): cur(0), top(0), _bytes(0), _objects(0) { }
+
+	~Arena(void) {
+		for(int i = 0; i < slabs.count(); i++)
+			delete [] slabs[i];
+	}
+
+	/**
+	 * Allocate a block of memory.
+	 * @param size	Size in bytes.
+	 * @return		Allocated block (aligned on 8 bytes).
+	 */
+	void *allocate(size_t size) {
+		size = (size + 7) & ~size_t(7);
+		if(cur + size > top) {
+			size_t ssize = size > size_t(SLAB_SIZE) ? size : size_t(SLAB_SIZE);
+			cur = new char[ssize];
+			top = cur + ssize;
+			slabs.add(cur);
+		}
+		void *r = cur;
+		cur += size;
+		_bytes += size;
+		_objects++;
+		return r;
+	}
+
+	inline t::uint64 bytes(void) const { return _bytes; }
+	inline t::uint64 objects(void) const { return _objects; }
+
+private:
+	genstruct::Vector<char *> slabs;
+	char *cur, *top;
+	t::uint64 _bytes, _objects;
+};
+
+
+/**
+ * The arena of the process must outlive the base otawa::Process that
+ * may delete the instructions: it is provided by this class, used as
+ * first base class of the Process.
+ */
+class ArenaOwner {
+protected:
+	Arena arena;
+	Arena sem_arena;
+};
+
+
+/**
+ * Table of the pre-decoded instructions of an executable segment.
+ * The information is stored as a structure of arrays indexed by
+ * the 32-bit word of the instruction address. Words that do not start
+ * an instruction (second word of a long instruction) are not valid.
+ */
+class InstTable {
+public:
+	static const t::uint8
+		VALID		= 0x01,
+		BUNDLE_HEAD	= 0x02;
+
+	/**
+	 * Pre-decode the instructions of a segment.
+	 * @param decoder	GLISS decoder.
+	 * @param mem		GLISS memory containing the program.
+	 * @param base		Base address of the segment.
+	 * @param size		Size of the segment in bytes.
+	 */
+	InstTable(patmos_decoder_t *decoder, patmos_memory_t *mem, Address base, t::uint32 size)
+	: _base(base), _count(size >> 2) {
+		kinds = new t::uint32[_count];
+		sizes = new t::uint8[_count];
+		flags = new t::uint8[_count];
+		targets = new t::uint32[_count];
+		delays = new t::uint8[_count];
+		slots = new t::uint8[_count];
+		wides = new t::uint8[_count];
+		reads = new reg_mask_t[_count];
+		writes = new reg_mask_t[_count];
+		for(int i = 0; i < _count; i++)
+			flags[i] = 0;
+
+		// decode the instructions
+		bool head = true;
+		for(int i = 0; i < _count; ) {
+			patmos_address_t a = (_base + (i << 2)).offset();
+			patmos_inst_t *inst = patmos_decode(decoder, a);
+			kinds[i] = inst->ident == PATMOS_UNKNOWN ? 0 : patmos_kind(inst);
+			sizes[i] = patmos_get_inst_size(inst) / 8;
+			if(!sizes[i])
+				sizes[i] = 4;	// unknown instruction or data word
+			flags[i] = VALID | (head ? BUNDLE_HEAD : 0);
+			targets[i] = kinds[i] & otawa::Inst::IS_CONTROL ? patmos_target(inst) : 0;
+			delays[i] = patmos_delayed(inst);
+			register_decoder.masks(inst, reads[i], writes[i]);
+			patmos_free_inst(inst);
+
+			// a 32-bit head with the bundle bit is followed by the second slot
+			head = !(head && sizes[i] == 4 && (patmos_mem_read32(mem, a) & 0x80000000));
+			i += sizes[i] >> 2;
+		}
+
+		// count the instructions in the delay slots of control instructions
+		for(int i = 0; i < _count; i++)
+			if((flags[i] & VALID) && (kinds[i] & otawa::Inst::IS_CONTROL))
+				countSlots(i);
+	}
+
+	~InstTable(void) {
+		delete [] kinds;
+		delete [] sizes;
+		delete [] flags;
+		delete [] targets;
+		delete [] delays;
+		delete [] slots;
+		delete [] wides;
+		delete [] reads;
+		delete [] writes;
+	}
+
+	inline Address base(void) const { return _base; }
+	inline int count(void) const { return _count; }
+	inline bool contains(Address a) const
+		{ return _base <= a && a < _base + (_count << 2); }
+	inline int index(Address a) const { return (a - _base) >> 2; }
+	inline bool isValid(Address a) const
+		{ return contains(a) && (flags[index(a)] & VALID); }
+
+	t::uint32 *kinds;
+	t::uint8 *sizes;
+	t::uint8 *flags;
+	t::uint32 *targets;
+	t::uint8 *delays;
+	t::uint8 *slots, *wides;
+	reg_mask_t *reads, *writes;
+
+private:
+
+	/**
+	 * Convert the delayed bundles of a control instruction into
+	 * a count of instructions. Bit k of wides records that the k-th
+	 * delayed instruction is a long one.
+	 * @param i		Index of the control instruction.
+	 */
+	void countSlots(int i) {
+		slots[i] = 0;
+		wides[i] = 0;
+		int j = i + (sizes[i] >> 2);
+		for(int n = delays[i]; n && j < _count; n--)
+			do {
+				if(sizes[j] == 8)
+					wides[i] |= 1 << slots[i];
+				slots[i]++;
+				j += sizes[j] ? sizes[j] >> 2 : 1;	// unknown word in a delay slot
+			} while(j < _count && !(flags[j] & BUNDLE_HEAD));
+	}
+
+	Address _base;
+	int _count;
+};
+
+
 // Platform class
 class Platform: public hard::Platform {
 public:
@@ -150,7 +984,7 @@ const Platform::Identification Platform::ID("patmos-");
  *   - the recognition of the instruction,
  *   - the assignment of the memory pointer.
  */
-class Process: public otawa::Process, public otawa::DelayedInfo {
+class Process: private ArenaOwner, public otawa::Process, public otawa::DelayedInfo {
 public:
 	Process(Manager *manager, hard::Platform *pf, const PropList& props = PropList::EMPTY);
 
@@ -165,15 +999,50 @@ public:
 
 	virtual int instSize(void) const { return 0; }
 	
-	void decodeRegs( Inst *inst, elm::genstruct::AllocatedTable<hard::Register *> *in, elm::genstruct::AllocatedTable<hard::Register *> *out);
+	void decodeMasks(Address addr, reg_mask_t& rd, reg_mask_t& wr);
 
 	inline patmos_decoder_t *patmosDecoder() { return _patmosDecoder;}
+
+	/**
+	 * Get the decoded instruction at the given address from the decode cache.
+	 * The result must not be freed and is only valid until the next call.
+	 * @param addr	Instruction address.
+	 * @return		Decoded instruction.
+	 */
+	inline patmos_inst_t *decodeInst(Address addr) { return _cache->get(addr.offset()); }
+	inline const DecodeCache& decodeCache(void) const { return *_cache; }
+	inline Arena& instArena(void) { return arena; }
+	inline const Arena& instArena(void) const { return arena; }
+	inline const Arena& semArena(void) const { return sem_arena; }
+
+	/**
+	 * Find the pre-decoded instruction table containing the given address.
+	 * @param addr	Instruction address.
+	 * @return		Matching table or null (no pre-decoding or not in code).
+	 */
+	inline InstTable *tableFor(Address addr) const {
+		for(int i = 0; i < tables.count(); i++)
+			if(tables[i]->contains(addr))
+				return tables[i];
+		return 0;
+	}
+
+	Symbol *functionAt(Address addr) const;
+	Symbol *symbolAt(Address addr) const;
+	ot::size functionSize(Address addr) const;
+
+	patmos_address_t decodeTarget(Address addr);
+	int decodeDelayed(Address addr);
+	void decodeSlots(Address addr, t::uint8& count, t::uint8& wides);
+	inline t::uint32 decodeStack(Address addr) { return patmos_stack(decodeInst(addr)); }
+	inline t::uint32 decodeAccess(Address addr) { return patmos_access(decodeInst(addr)); }
 	
 	inline void *patmosPlatform(void) const { return _patmosPlatform; }
 
 	void setup(void);
 	
 	void getSem(otawa::Inst *inst, sem::Block& block);
+	int decodeSem(otawa::Inst *inst, sem::inst *& ops);
 
 	// Process Overloads
 	virtual hard::Platform *platform(void) { return _platform; }
@@ -205,35 +1074,19 @@ public:
 			return otawa::DELAYED_None;
 	}
 
-	virtual int count(Inst *oinst) {
-
-		// get the rough delay slot information (in bundles)
-		patmos_inst_t *inst;
-		inst = patmos_decode(patmosDecoder(), (patmos_address_t)oinst->address());
-		int n = patmos_delayed(inst);
-
-		// convert it in instructions
-		int cnt = 0;
-		Inst *i = oinst;
-		for(; n; n--) {
-			Address a = i->topAddress();
-			Address t = a + info.bundleSize(a);
-			while(a < t) {
-				i = findInstAt(i->topAddress());
-				if(!i)
-					throw LoadException(_ << "no slot at " << a << " as it should be!");
-				cnt++;
-				a += i->size();
-			}
-		}
-		return cnt;
-	}
+	virtual int count(Inst *oinst);
 
 protected:
 	friend class Segment;
 
 	virtual otawa::Inst *decode(Address addr);
 
+	void loadPlatform(void);
+	void importSymbols(File *file, const ElfImage& elf);
+	void importSymbols(File *file, gel_file_t *gel);
+	void importSymbol(File *file, genstruct::Vector<SymbolIndex::entry_t>& entries,
+		cstring name, int type, t::uint32 value, t::uint32 size);
+
 	virtual gel_file_t *gelFile(void) { return _gelFile; }
 	
 	virtual patmos_memory_t *patmosMemory(void) { return _patmosMemory; }
@@ -244,11 +1097,19 @@ private:
 	patmos_platform_t *_patmosPlatform;
 	patmos_memory_t *_patmosMemory;
 	patmos_decoder_t *_patmosDecoder;
+	DecodeCache *_cache;
+	genstruct::Vector<InstTable *> tables;
+	bool predecode;
+	ElfImage *image;
+	bool mapped, loaded;
+	string _path;
 	int argc;
 	char **argv, **envp;
 	bool no_stack;
 	bool init;
 	struct gel_line_map_t *map;
+	LineIndex *lines;
+	SymbolIndex syms;
 	struct gel_file_info_t *file;
 	gel_file_t *_gelFile;
 	Info info;
@@ -263,25 +1124,24 @@ elm::io::Output& operator<<(elm::io::Output& out, Process *proc)
 class Inst: public otawa::Inst {
 public:
 
-	inline Inst(Process& process, kind_t kind, Address addr, ot::size size)
-		: proc(process), _kind(kind), _addr(addr), isRegsDone(false), _size(size) { }
+	inline Inst(Process& process)
+		: proc(process), _sem(0), _semCount(0), isRegsDone(false), isSemDone(false) { }
+
+	// instructions are allocated in the arena of the process
+	static void *operator new(size_t size, Arena& arena) { return arena.allocate(size); }
+	static void operator delete(void *p, Arena& arena) { }
+	static void operator delete(void *p) { }
 
 	/**
 	 */
 	void dump(io::Output& out) {
 		char out_buffer[200];
-		patmos_inst_t *inst = patmos_decode(proc.patmosDecoder(), _addr);
-		patmos_disasm(out_buffer, inst);
-		patmos_free_inst(inst);
+		patmos_disasm(out_buffer, proc.decodeInst(address()));
 		out << out_buffer;
 	}
 
-	virtual kind_t kind(void) { return _kind; }
-	virtual address_t address(void) const { return _addr; }
 	virtual Process &process() { return proc; }
 
-	virtual ot::size size(void) const { return _size; }
-
 	virtual const elm::genstruct::Table<hard::Register *>& readRegs() {
 		if (!isRegsDone) {
 			decodeRegs();
@@ -299,32 +1159,86 @@ public:
 	}
 
 	virtual void semInsts (sem::Block &block) {
-		proc.getSem(this, block);
+		if(!isSemDone) {
+			_semCount = proc.decodeSem(this, _sem);
+			isSemDone = true;
+		}
+		for(int i = 0; i < _semCount; i++)
+			block.add(_sem[i]);
 	}
 
+	virtual reg_mask_t readMask(void) = 0;
+	virtual reg_mask_t writeMask(void) = 0;
+
 protected:
 	virtual void decodeRegs(void) {
-		proc.decodeRegs(this, &in_regs, &out_regs);
+		reg_mask_t rd = readMask(), wr = writeMask();
+		int rn = __builtin_popcountll(rd), wn = __builtin_popcountll(wr);
+		hard::Register **regs = 0;
+		if(rn + wn)
+			regs = static_cast<hard::Register **>(proc.instArena().allocate((rn + wn) * sizeof(hard::Register *)));
+		register_decoder.toArray(rd, regs);
+		register_decoder.toArray(wr, regs + rn);
+		in_regs = elm::genstruct::Table<hard::Register *>(regs, rn);
+		out_regs = elm::genstruct::Table<hard::Register *>(regs + rn, wn);
 	}
 
-	kind_t _kind;
-	elm::genstruct::AllocatedTable<hard::Register *> in_regs;
-	elm::genstruct::AllocatedTable<hard::Register *> out_regs;
+	elm::genstruct::Table<hard::Register *> in_regs;
+	elm::genstruct::Table<hard::Register *> out_regs;
 	Process &proc;
 
+private:
+	sem::inst *_sem;
+	t::uint16 _semCount;
+	bool isRegsDone, isSemDone;
+};
+
+
+// DecodedInst class: instruction decoded on its own
+class DecodedInst: public Inst {
+public:
+
+	inline DecodedInst(Process& process, kind_t kind, Address addr, ot::size size)
+		: Inst(process), _kind(kind), _addr(addr), _size(size), isMaskDone(false) { }
+
+	virtual kind_t kind(void) { return _kind; }
+	virtual address_t address(void) const { return _addr; }
+	virtual ot::size size(void) const { return _size; }
+
+	virtual reg_mask_t readMask(void) {
+		if(!isMaskDone)
+			decodeMasks();
+		return read_mask;
+	}
+
+	virtual reg_mask_t writeMask(void) {
+		if(!isMaskDone)
+			decodeMasks();
+		return write_mask;
+	}
+
+protected:
+	void decodeMasks(void) {
+		proc.decodeMasks(_addr, read_mask, write_mask);
+		isMaskDone = true;
+	}
+
+	kind_t _kind;
+
 private:
 	patmos_address_t _addr;
 	ot::size _size;
-	bool isRegsDone;
+	reg_mask_t read_mask, write_mask;
+	bool isMaskDone;
 };
 
 
 // BranchInst class
-class BranchInst: public Inst {
+class BranchInst: public DecodedInst {
 public:
 
 	inline BranchInst(Process& process, kind_t kind, Address addr, ot::size size)
-	: Inst(process, kind, addr, size), _target(0), isTargetDone(false) {
+	: DecodedInst(process, kind, addr, size), _target(0), _slots(0), _wides(0), isTargetDone(false), isSlotsDone(false) {
 	}
 
 	virtual ot::size size() const { return 4; }
@@ -340,11 +1254,28 @@ public:
 	}
 
         virtual delayed_t delayType(void) {
-	  return _delaySlots > 0 ? otawa::DELAYED_Always : otawa::DELAYED_None;
+	  return delaySlots() > 0 ? otawa::DELAYED_Always : otawa::DELAYED_None;
 	}
 
 	virtual int delaySlots(void) {
-	  return _delaySlots;
+		if(!isSlotsDone) {
+			proc.decodeSlots(address(), _slots, _wides);
+			isSlotsDone = true;
+		}
+		return _slots;
+	}
+
+	/**
+	 * Get the address of a delayed instruction.
+	 * @param i		Index of the delayed instruction (in [0, delaySlots()[).
+	 * @return		Address of the delayed instruction.
+	 */
+	Address slotAddress(int i) {
+		ASSERTP(i < delaySlots(), "delay slot index out of bounds");
+		Address a = topAddress();
+		for(int k = 0; k < i; k++)
+			a += (_wides & (1 << k)) ? 8 : 4;
+		return a;
 	}
 
 protected:
@@ -352,23 +1283,72 @@ protected:
 
 private:
 	otawa::Inst *_target;
-	int _delaySlots;
-	bool isTargetDone;
+	t::uint8 _slots, _wides;
+	bool isTargetDone, isSlotsDone;
 };
 
 
-// Segment class
-class Segment: public otawa::Segment {
+// TableInst class: thin view over a pre-decoded instruction table
+class TableInst: public Inst {
 public:
-	Segment(Process& process,
-		CString name,
-		address_t address,
-		size_t size)
-	: otawa::Segment(name, address, size, EXECUTABLE), proc(process) { }
 
-protected:
-	virtual otawa::Inst *decode(address_t address)
-		{ return proc.decode(address); }
+	inline TableInst(Process& process, const InstTable& table, int index)
+		: Inst(process), tab(table), idx(index) { }
+
+	virtual kind_t kind(void) { return tab.kinds[idx]; }
+	virtual address_t address(void) const { return tab.base() + (idx << 2); }
+	virtual ot::size size(void) const { return tab.sizes[idx]; }
+	virtual reg_mask_t readMask(void) { return tab.reads[idx]; }
+	virtual reg_mask_t writeMask(void) { return tab.writes[idx]; }
+
+protected:
+	const InstTable& tab;
+	int idx;
+};
+
+
+// TableBranchInst class: thin view over a pre-decoded control instruction
+class TableBranchInst: public TableInst {
+public:
+
+	inline TableBranchInst(Process& process, const InstTable& table, int index)
+		: TableInst(process, table, index), _target(0), isTargetDone(false) { }
+
+	virtual ot::size size() const { return 4; }
+
+	virtual otawa::Inst *target() {
+		if (!isTargetDone) {
+			if (tab.targets[idx])
+				_target = process().findInstAt(tab.targets[idx]);
+			isTargetDone = true;
+		}
+		return _target;
+	}
+
+	virtual delayed_t delayType(void) {
+		return tab.slots[idx] > 0 ? otawa::DELAYED_Always : otawa::DELAYED_None;
+	}
+
+	virtual int delaySlots(void) { return tab.slots[idx]; }
+
+private:
+	otawa::Inst *_target;
+	bool isTargetDone;
+};
+
+
+// Segment class
+class Segment: public otawa::Segment {
+public:
+	Segment(Process& process,
+		CString name,
+		address_t address,
+		size_t size)
+	: otawa::Segment(name, address, size, EXECUTABLE), proc(process) { }
+
+protected:
+	virtual otawa::Inst *decode(address_t address)
+		{ return proc.decode(address); }
 
 private:
 	Process& proc;
@@ -390,7 +1370,9 @@ Process::Process(Manager *manager, hard::Platform *platform, const PropList& pro
 	_patmosMemory(0),
 	init(false),
 	map(0),
+	lines(0),
 	file(0),
+	_gelFile(0),
 	info(*this)
 {
 	ASSERTP(manager, "manager required");
@@ -401,6 +1383,11 @@ Process::Process(Manager *manager, hard::Platform *platform, const PropList& pro
 	ASSERTP(_patmosPlatform, "otawa::patmos::Process::Process(..), cannot create a patmos_platform");
 	_patmosDecoder = patmos_new_decoder(_patmosPlatform);
 	ASSERTP(_patmosDecoder, "otawa::patmos::Process::Process(..), cannot create a patmos_decoder");
+	_cache = new DecodeCache(_patmosDecoder, DECODE_CACHE_SIZE(props));
+	predecode = PREDECODE(props);
+	image = 0;
+	mapped = MAP_FILE(props);
+	loaded = false;
 	_patmosMemory = patmos_get_memory(_patmosPlatform, PATMOS_MAIN_MEMORY);
 	ASSERTP(_patmosMemory, "otawa::patmos::Process::Process(..), cannot get main patmos_memory");
 	patmos_lock_platform(_patmosPlatform);
@@ -435,75 +1422,176 @@ Process::Process(Manager *manager, hard::Platform *platform, const PropList& pro
 /**
  */
 Process::~Process() {
+	for(int i = 0; i < tables.count(); i++)
+		delete tables[i];
+	delete _cache;
 	patmos_delete_decoder(_patmosDecoder);
 	patmos_unlock_platform(_patmosPlatform);
 	if(_gelFile)
 		gel_close(_gelFile);
+	if(image)
+		delete image;
+	if(lines)
+		delete lines;
 }
 
 
 
 Option<Pair<cstring, int> > Process::getSourceLine(Address addr) throw (UnsupportedFeatureException) {
 	setup();
-	if (!map)
+	if (!lines)
 		return none;
-	const char *file;
-	int line;
-	if (!map || gel_line_from_address(map, addr.offset(), &file, &line) < 0)
+	const LineIndex::line_t *l = lines->find(addr.offset());
+	if(!l)
 		return none;
-	return some(pair(cstring(file), line));
+	return some(pair(cstring(l->file), l->line));
 }
 
 
 void Process::getAddresses(cstring file, int line, Vector<Pair<Address, Address> >& addresses) throw (UnsupportedFeatureException) {
 	setup();
 	addresses.clear();
-	if (!map)
+	if (!lines)
 		return;
-	gel_line_iter_t iter;
-	gel_location_t loc, ploc = { 0, 0, 0, 0 };
-	for (loc = gel_first_line(&iter, map); loc.file; loc = gel_next_line(&iter))
-	{
-		cstring lfile = loc.file;
-		//cerr << loc.file << ":" << loc.line << ", " << loc.low_addr << "-" << loc.high_addr << io::endl;
-		if (file == loc.file || lfile.endsWith(file))
-		{
-			if (line == loc.line)
-			{
-				//cerr << "added (1) " << loc.file << ":" << loc.line << " -> " << loc.low_addr << io::endl;
-				addresses.add(pair(Address(loc.low_addr), Address(loc.high_addr)));
-			}
-			else if(loc.file == ploc.file && line > ploc.line && line < loc.line)
-			{
-				//cerr << "added (2) " << ploc.file << ":" << ploc.line << " -> " << ploc.low_addr << io::endl;
-				addresses.add(pair(Address(ploc.low_addr), Address(ploc.high_addr)));
-			}
-		}
-		ploc = loc;
-	}
+	lines->find(file, line, addresses);
 }
 
 
 /**
- * Setup the source line map.
+ * Setup the source line map and its indexes.
  */
 void Process::setup(void) {
-	ASSERT(_gelFile);
 	if(init)
 		return;
 	init = true;
+	if(!_gelFile)
+		_gelFile = gel_open(&_path, 0, GEL_OPEN_NOPLUGINS);
+	ASSERT(_gelFile);
 	map = gel_new_line_map(_gelFile);
+	if(map)
+		lines = new LineIndex(map);
 }
 
-File *Process::loadFile(elm::CString path) {
+
+/**
+ * Import the symbols of the ELF file in one pass over its symbol table
+ * and build the symbol index by address.
+ * @param file	File to add symbols to.
+ * @param elf	Mapped ELF image.
+ */
+void Process::importSymbols(File *file, const ElfImage& elf) {
 	LTRACE;
+	genstruct::Vector<SymbolIndex::entry_t> entries;
+	for(int i = 0; i < elf.symbolCount(); i++)
+		importSymbol(file, entries, elf.symbolName(i), elf.symbolType(i), elf.symbolValue(i), elf.symbolSize(i));
+	syms.build(entries);
+}
 
-	// Check if there is not an already opened file !
-	if(program())
-		throw LoadException("loader cannot open multiple files !");
 
-	File *file = new otawa::File(path);
-	addFile(file);
+/**
+ * Import the symbols of the ELF file in one pass over the symbol table
+ * of the already opened GEL file and build the symbol index by address.
+ * @param file	File to add symbols to.
+ * @param gel	Opened GEL file.
+ */
+void Process::importSymbols(File *file, gel_file_t *gel) {
+	LTRACE;
+	genstruct::Vector<SymbolIndex::entry_t> entries;
+	gel_sym_iter_t iter;
+	for(gel_sym_t *sym = gel_sym_first(&iter, gel); sym; sym = gel_sym_next(&iter)) {
+		gel_sym_info_t infos;
+		gel_sym_infos(sym, &infos);
+		importSymbol(file, entries, infos.name, ELF32_ST_TYPE(infos.info), infos.vaddr, infos.size);
+	}
+	syms.build(entries);
+}
+
+
+/**
+ * Import a function or label symbol.
+ * @param file		File to add the symbol to.
+ * @param entries	Index entries to add the symbol to.
+ * @param name		Symbol name.
+ * @param type		ELF symbol type.
+ * @param value		Symbol value.
+ * @param size		Symbol size.
+ */
+void Process::importSymbol(File *file, genstruct::Vector<SymbolIndex::entry_t>& entries,
+cstring name, int type, t::uint32 value, t::uint32 size) {
+	Symbol::kind_t kind;
+	switch(type) {
+	case STT_FUNC:
+		kind = Symbol::FUNCTION;
+		break;
+	case STT_NOTYPE:
+		kind = Symbol::LABEL;
+		break;
+	default:
+		return;
+	}
+
+	// Build the label if required
+	address_t addr = value;
+	if(addr) {
+		String label(name);
+		Symbol *sym = new Symbol(*file, label, kind, addr);
+		file->addSymbol(sym);
+		TRACE("symbol " << label << " at " << addr);
+		SymbolIndex::entry_t e;
+		e.addr = addr.offset();
+		e.size = size;
+		e.sym = sym;
+		entries.add(e);
+	}
+}
+
+
+/**
+ * Find the function containing the given address.
+ * @param addr	Looked address.
+ * @return		Containing function symbol or null.
+ */
+Symbol *Process::functionAt(Address addr) const {
+	const SymbolIndex::entry_t *e = syms.function(addr.offset());
+	if(!e || (e->size && addr.offset() >= e->addr + e->size))
+		return 0;
+	return e->sym;
+}
+
+
+/**
+ * Get the size of the function starting at the given address,
+ * as given by its ELF symbol.
+ * @param addr	Function address.
+ * @return		Function size or 0 if unknown.
+ */
+ot::size Process::functionSize(Address addr) const {
+	const SymbolIndex::entry_t *e = syms.function(addr.offset());
+	if(!e || e->addr != addr.offset())
+		return 0;
+	return e->size;
+}
+
+
+/**
+ * Find the nearest symbol at or before the given address.
+ * @param addr	Looked address.
+ * @return		Found symbol or null.
+ */
+Symbol *Process::symbolAt(Address addr) const {
+	const SymbolIndex::entry_t *e = syms.symbol(addr.offset());
+	return e ? e->sym : 0;
+}
+
+
+/**
+ * Load the program in the GLISS platform, as required by simulation.
+ * When the file is mapped, this is only performed on demand.
+ */
+void Process::loadPlatform(void) {
+	if(loaded)
+		return;
+	loaded = true;
 
 	// initialize the environment
 	ASSERTP(_patmosPlatform, "invalid patmos_platform !");
@@ -514,8 +1602,45 @@ File *Process::loadFile(elm::CString path) {
 	env->envp = envp;
 
 	// load the binary
-	if(patmos_load_platform(_patmosPlatform, (char *)&path) == -1)
-		throw LoadException(_ << "cannot load \"" << path << "\".");
+	if(patmos_load_platform(_patmosPlatform, (char *)&_path) == -1)
+		throw LoadException(_ << "cannot load \"" << _path << "\".");
+}
+
+File *Process::loadFile(elm::CString path) {
+	LTRACE;
+
+	// Check if there is not an already opened file !
+	if(program())
+		throw LoadException("loader cannot open multiple files !");
+
+	File *file = new otawa::File(path);
+	addFile(file);
+	_path = path;
+
+	// mapped file: sections and symbols come from the mapping
+	if(mapped) {
+		image = new ElfImage(path);
+		for(int i = 0; i < image->sectionCount(); i++)
+			if(image->sectionFlags(i) & SHF_EXECINSTR) {
+				t::uint32 vaddr = image->sectionAddress(i), size = image->sectionSize(i);
+				Segment *seg = new Segment(*this, image->sectionName(i), vaddr, size);
+				file->addSegment(seg);
+
+				// the decoder fetches the code from the GLISS memory
+				if(image->sectionType(i) != SHT_NOBITS)
+					patmos_mem_write(_patmosMemory, vaddr, (void *)image->sectionData(i), size);
+				info.addBundleMap(vaddr, size);
+				if(predecode)
+					tables.add(new InstTable(_patmosDecoder, _patmosMemory, vaddr, size));
+			}
+		importSymbols(file, *image);
+		LTRACE;
+		_start = findInstAt(address_t(image->entry()));
+		return file;
+	}
+
+	// load the binary
+	loadPlatform();
 
 	// get the initial state
 	//SimState *state = dynamic_cast<SimState *>(newState());
@@ -537,45 +1662,14 @@ File *Process::loadFile(elm::CString path) {
 		if (infos.flags & SHF_EXECINSTR) {
 			Segment *seg = new Segment(*this, infos.name, infos.vaddr, infos.size);
 			file->addSegment(seg);
+			info.addBundleMap(infos.vaddr, infos.size);
+			if(predecode)
+				tables.add(new InstTable(_patmosDecoder, _patmosMemory, infos.vaddr, infos.size));
 		}
 	}
 
 	// Initialize symbols
-	LTRACE;
-	gel_enum_t *iter = gel_enum_file_symbol(_gelFile);
-	gel_enum_initpos(iter);
-	for(char *name = (char *)gel_enum_next(iter); name; name = (char *)gel_enum_next(iter)) {
-		ASSERT(name);
-		address_t addr = 0;
-		Symbol::kind_t kind;
-		gel_sym_t *sym = gel_find_file_symbol(_gelFile, name);
-		assert(sym);
-		gel_sym_info_t infos;
-		gel_sym_infos(sym, &infos);
-		switch(ELF32_ST_TYPE(infos.info)) {
-		case STT_FUNC:
-			kind = Symbol::FUNCTION;
-			addr = (address_t)infos.vaddr;
-			TRACE("SYMBOL: function " << infos.name << " at " << addr);
-			break;
-		case STT_NOTYPE:
-			kind = Symbol::LABEL;
-			addr = (address_t)infos.vaddr;
-			TRACE("SYMBOL: notype " << infos.name << " at " << addr);
-			break;
-		default:
-			continue;
-		}
-
-		// Build the label if required
-		if(addr) {
-			String label(infos.name);
-			Symbol *sym = new Symbol(*file, label, kind, addr);
-			file->addSymbol(sym);
-			TRACE("function " << label << " at " << addr);
-		}
-	}
-	gel_enum_free(iter);
+	importSymbols(file, _gelFile);
 
 	// Last initializations
 	LTRACE;
@@ -589,7 +1683,10 @@ File *Process::loadFile(elm::CString path) {
 // Memory read
 #define GET(t, s) \
 	void Process::get(Address at, t& val) { \
-			val = patmos_mem_read##s(_patmosMemory, at.offset()); \
+			if(image) \
+				val = t(image->read(at.offset(), s / 8)); \
+			else \
+				val = patmos_mem_read##s(_patmosMemory, at.offset()); \
 			/*cerr << "val = " << (void *)(int)val << " at " << at << io::endl;*/ \
 	}
 GET(t::int8, 8);
@@ -600,119 +1697,207 @@ GET(t::int32, 32);
 GET(t::uint32, 32);
 GET(t::int64, 64);
 GET(t::uint64, 64);
-GET(Address, 32);
 
 
-void Process::get(Address at, string& str) {
-	Address base = at;
-	while(!patmos_mem_read8(_patmosMemory, at.offset()))
-		at = at + 1;
-	int len = at - base;
-	char buf[len];
-	get(base, buf, len);
-	str = String(buf, len);
+void Process::get(Address at, Address& val) {
+	if(image)
+		val = Address(t::uint32(image->read(at.offset(), 4)));
+	else
+		val = patmos_mem_read32(_patmosMemory, at.offset());
 }
 
 
-void Process::get(Address at, char *buf, int size)
-	{ patmos_mem_read(_patmosMemory, at.offset(), buf, size); }
-
+void Process::get(Address at, string& str) {
 
+	// fast path: null character in the same section
+	if(image) {
+		t::uint32 avail;
+		const char *p = reinterpret_cast<const char *>(image->span(at.offset(), avail));
+		if(p) {
+			const char *e = static_cast<const char *>(memchr(p, 0, avail));
+			if(e) {
+				str = String(p, e - p);
+				return;
+			}
+		}
+	}
 
-void Process::decodeRegs(otawa::Inst *oinst, elm::genstruct::AllocatedTable<hard::Register *> *in,
-	elm::genstruct::AllocatedTable<hard::Register *> *out)
-{
-	// Decode instruction
-	patmos_inst_t *inst;
-	inst = patmos_decode(_patmosDecoder, oinst->address().offset());
-	if(inst->ident == PATMOS_UNKNOWN)
-	{
-		patmos_free_inst(inst);
-		return;
+	// else copy aligned chunks: as they divide the GLISS memory pages,
+	// a chunk never crosses a page boundary
+	static const int CHUNK = 256;
+	char chunk[CHUNK];
+	StringBuffer buf;
+	t::uint32 a = at.offset();
+	for(bool first = true; ; first = false) {
+		int n = CHUNK - (a & (CHUNK - 1));
+		get(Address(a), chunk, n);
+		const char *e = static_cast<const char *>(memchr(chunk, 0, n));
+		if(e) {
+			if(first)
+				str = String(chunk, e - chunk);
+			else {
+				buf << String(chunk, e - chunk);
+				str = buf.toString();
+			}
+			return;
+		}
+		buf << String(chunk, n);
+		a += n;
 	}
+}
 
-	// get register infos
-	patmos_used_regs_read_t rds;
-	patmos_used_regs_write_t wrs;
-	elm::genstruct::Vector<hard::Register *> reg_in;
-	elm::genstruct::Vector<hard::Register *> reg_out;
-        patmos_used_regs(inst, rds, wrs);
-        for (int i = 0; rds[i] != -1; i++ ) {
-            hard::Register *r = register_decoder[rds[i]];
-            if(r)
-                reg_in.add(r);
-        }
-        for (int i = 0; wrs[i] != -1; i++ ) {
-            hard::Register *r = register_decoder[wrs[i]];
-            if(r)
-                reg_out.add(r);
-        } 
 
-	// store results
-	int cpt_in = reg_in.length();
-	in->allocate(cpt_in);
-	for (int i = 0 ; i < cpt_in ; i++)
-		in->set(i, reg_in.get(i));
-	int cpt_out = reg_out.length();
-	out->allocate(cpt_out);
-	for (int i = 0 ; i < cpt_out ; i++)
-		out->set(i, reg_out.get(i));
+void Process::get(Address at, char *buf, int size) {
+	if(image)
+		image->read(at.offset(), buf, size);
+	else
+		patmos_mem_read(_patmosMemory, at.offset(), buf, size);	// copied page per page
+}
 
-	// Free instruction
-	patmos_free_inst(inst);
+
+
+/**
+ * Get the masks of read and written registers of an instruction.
+ * @param addr	Instruction address.
+ * @param rd	Mask of read registers.
+ * @param wr	Mask of written registers.
+ */
+void Process::decodeMasks(Address addr, reg_mask_t& rd, reg_mask_t& wr) {
+	InstTable *table = tableFor(addr);
+	if(table && table->isValid(addr)) {
+		rd = table->reads[table->index(addr)];
+		wr = table->writes[table->index(addr)];
+	}
+	else
+		register_decoder.masks(decodeInst(addr), rd, wr);
 }
 
 
 otawa::Inst *Process::decode(Address addr) {
 	//cerr << "DECODING: " << addr << io::endl;
 
-	// Decode the instruction
-	patmos_inst_t *inst;
-	TRACE("ADDR " << addr);
-	inst = patmos_decode(_patmosDecoder, (patmos_address_t)addr.offset());
-
 	// Build the instruction
 	Inst::kind_t kind = 0;
+	ot::size size;
 	otawa::Inst *result = 0;
 
+	// pre-decoded instruction: build a view over the table
+	InstTable *table = tableFor(addr);
+	if(table && table->isValid(addr)) {
+		int i = table->index(addr);
+		if(table->kinds[i] & Inst::IS_CONTROL)
+			return new(arena) TableBranchInst(*this, *table, i);
+		else
+			return new(arena) TableInst(*this, *table, i);
+	}
+
+	// else decode the instruction
+	TRACE("ADDR " << addr);
+	patmos_inst_t *inst = decodeInst(addr);
+
 	// get the kind from the nmp otawa_kind attribute
 	if(inst->ident == PATMOS_UNKNOWN)
 		TRACE("UNKNOWN !!!\n" << result);
 	else
 		kind = patmos_kind(inst);
-
-	bool is_branch = kind & Inst::IS_CONTROL;
+	size = patmos_get_inst_size(inst) / 8;
+	if(!size)
+		size = 4;
 
 	// build the object
-	ot::size size = patmos_get_inst_size(inst) / 8;
+	bool is_branch = kind & Inst::IS_CONTROL;
 	if (is_branch)
-		result = new BranchInst(*this, kind, addr, size);
+		result = new(arena) BranchInst(*this, kind, addr, size);
 	else
-		result = new Inst(*this, kind, addr, size);
+		result = new(arena) DecodedInst(*this, kind, addr, size);
 
-	// cleanup
 	ASSERT(result);
-	patmos_free_inst(inst);
 	return result;
 }
 
 
 
-patmos_address_t BranchInst::decodeTargetAddress(void) {
-
-	// Decode the instruction
-	patmos_inst_t *inst;
+/**
+ * Get the target of the branch at the given address.
+ * @param addr	Branch address.
+ * @return		Target address or 0 if unknown.
+ */
+patmos_address_t Process::decodeTarget(Address addr) {
+	InstTable *table = tableFor(addr);
+	if(table && table->isValid(addr))
+		return table->targets[table->index(addr)];
 	TRACE("ADDR " << addr);
-	inst = patmos_decode(proc.patmosDecoder(), (patmos_address_t)address());
+	return patmos_target(decodeInst(addr));
+}
+
+
+/**
+ * Get the number of delayed bundles of the branch at the given address.
+ * @param addr	Branch address.
+ * @return		Number of delayed bundles.
+ */
+int Process::decodeDelayed(Address addr) {
+	InstTable *table = tableFor(addr);
+	if(table && table->isValid(addr))
+		return table->delays[table->index(addr)];
+	return patmos_delayed(decodeInst(addr));
+}
+
+
+/**
+ * Get the delay slots of the branch at the given address as a number
+ * of instructions. Bit k of wides is set if the k-th delayed instruction
+ * is a long one.
+ * @param addr	Branch address.
+ * @param count	Returned number of delayed instructions.
+ * @param wides	Returned long instruction bits.
+ */
+void Process::decodeSlots(Address addr, t::uint8& count, t::uint8& wides) {
+	InstTable *table = tableFor(addr);
+	if(table && table->isValid(addr)) {
+		count = table->slots[table->index(addr)];
+		wides = table->wides[table->index(addr)];
+		return;
+	}
+
+	// convert the delayed bundles in instructions
+	int n = decodeDelayed(addr);
+	count = 0;
+	wides = 0;
+	Address a = addr + patmos_get_inst_size(decodeInst(addr)) / 8;
+	for(; n; n--) {
+		Address t = a + info.bundleSize(a);
+		while(a < t) {
+			int size = patmos_get_inst_size(decodeInst(a)) / 8;
+			if(!size)
+				size = 4;	// unknown word in a delay slot
+			if(size == 8)
+				wides |= 1 << count;
+			count++;
+			a += size;
+		}
+	}
+}
+
+
+/**
+ * DelayedInfo implementation: the delay slots are computed once
+ * by the branch instruction itself.
+ */
+int Process::count(otawa::Inst *inst) {
+	if(!inst->isControl())
+		return 0;
+	return inst->delaySlots();
+}
+
+
+patmos_address_t BranchInst::decodeTargetAddress(void) {
 
 	// retrieve the target addr from the nmp otawa_target attribute
 	Address target_addr;
-	patmos_address_t res = patmos_target(inst);
+	patmos_address_t res = proc.decodeTarget(address());
 	if(res != 0)
 		target_addr = res;
-
-	// Return result
-	patmos_free_inst(inst);
 	return target_addr;
 }
 
@@ -786,6 +1971,73 @@ otawa::Process *Loader::create(Manager *man, const PropList& props)
 }
 
 
+/**
+ * Bundle map of an executable segment: for each 32-bit word, records
+ * if it starts a bundle and if its bundle bit (bit 31) is set.
+ */
+class BundleMap {
+public:
+
+	/**
+	 * Build the bundle map by scanning the segment words.
+	 * @param proc	Process to read the words from.
+	 * @param base	Base address of the segment.
+	 * @param size	Size of the segment in bytes.
+	 */
+	BundleMap(otawa::Process& proc, const Address& base, t::uint32 size)
+	: _base(base), _count(size >> 2) {
+		int n = (_count + 31) >> 5;
+		heads = new t::uint32[n];
+		wides = new t::uint32[n];
+		for(int i = 0; i < n; i++) {
+			heads[i] = 0;
+			wides[i] = 0;
+		}
+		for(int i = 0; i < _count; i++) {
+			t::uint32 w;
+			proc.get(_base + (i << 2), w);
+			if(w & 0x80000000)
+				wides[i >> 5] |= 1U << (i & 0x1f);
+		}
+		for(int i = 0; i < _count; i += isWide(i) ? 2 : 1)
+			heads[i >> 5] |= 1U << (i & 0x1f);
+	}
+
+	~BundleMap(void) {
+		delete [] heads;
+		delete [] wides;
+	}
+
+	inline bool contains(const Address& a) const
+		{ return _base <= a && a < _base + (_count << 2); }
+	inline int index(const Address& a) const { return (a - _base) >> 2; }
+	inline bool isHead(int i) const { return heads[i >> 5] & (1U << (i & 0x1f)); }
+	inline bool isWide(int i) const { return wides[i >> 5] & (1U << (i & 0x1f)); }
+
+	/**
+	 * Find the index of the next bundle start after the given index.
+	 * @param i		Current index.
+	 * @return		Next bundle start index or -1 if there is none.
+	 */
+	int next(int i) const {
+		for(i++; i < _count; i++) {
+			t::uint32 w = heads[i >> 5] >> (i & 0x1f);
+			if(w)
+				return i + __builtin_ctz(w) < _count ? i + __builtin_ctz(w) : -1;
+			i |= 0x1f;
+		}
+		return -1;
+	}
+
+	inline Address address(int i) const { return _base + (i << 2); }
+
+private:
+	Address _base;
+	int _count;
+	t::uint32 *heads, *wides;
+};
+
+
 /**
  * @class Info
  * Provide information specific to the PatMOS architecture.
@@ -798,6 +2050,37 @@ otawa::Process *Loader::create(Manager *man, const PropList& props)
 Info::Info(otawa::Process& _proc): proc(_proc) {
 }
 
+
+/**
+ */
+Info::~Info(void) {
+	for(int i = 0; i < maps.count(); i++)
+		delete maps[i];
+}
+
+
+/**
+ * Build the bundle map of an executable segment.
+ * @param base	Segment base address.
+ * @param size	Segment size in bytes.
+ */
+void Info::addBundleMap(const Address& base, t::uint32 size) {
+	maps.add(new BundleMap(proc, base, size));
+}
+
+
+/**
+ * Find the bundle map containing the given address.
+ * @param addr	Looked address.
+ * @return		Matching bundle map or null.
+ */
+BundleMap *Info::mapFor(const Address& addr) const {
+	for(int i = 0; i < maps.count(); i++)
+		if(maps[i]->contains(addr))
+			return maps[i];
+	return 0;
+}
+
 	
 /**
  * Get the size in bytes of a bundle starting at the given address.
@@ -805,6 +2088,9 @@ Info::Info(otawa::Process& _proc): proc(_proc) {
  * @return		4 for a 32-bits bundle, 8 bits for a 64-bits bundle.
  */
 int Info::bundleSize(const Address& addr) {
+	BundleMap *map = mapFor(addr);
+	if(map)
+		return map->isWide(map->index(addr)) ? 8 : 4;
 	t::uint32 w;
 	proc.get(addr, w);
 	if(w & 0x80000000)
@@ -814,6 +2100,229 @@ int Info::bundleSize(const Address& addr) {
 }
 
 
+/**
+ * Test if the bundles at the given address are given by a bundle map,
+ * that is, without reading the memory of the process.
+ * @param addr	Address to test.
+ * @return		True if the address is in an executable segment.
+ */
+bool Info::hasBundleMap(const Address& addr) const {
+	return mapFor(addr) != 0;
+}
+
+
+/**
+ * Test if the given address starts a bundle.
+ * @param addr	Address to test.
+ * @return		True if a bundle starts at this address, false else
+ * 				(or if the address is not in an executable segment).
+ */
+bool Info::isBundleStart(const Address& addr) {
+	BundleMap *map = mapFor(addr);
+	return map && map->isHead(map->index(addr));
+}
+
+
+/**
+ * Get the start address of the first bundle after the given address.
+ * @param addr	Current address.
+ * @return		Next bundle address or null address if there is no more
+ * 				bundle in the segment.
+ */
+Address Info::nextBundle(const Address& addr) {
+	BundleMap *map = mapFor(addr);
+	if(!map)
+		return addr + bundleSize(addr);
+	int i = map->next(map->index(addr));
+	if(i < 0)
+		return Address::null;
+	else
+		return map->address(i);
+}
+
+
+/**
+ * Get the number of decoding requests served by the decode cache.
+ * @return	Decode cache hits.
+ */
+t::uint64 Info::decodeHits(void) const {
+	return static_cast<const Process&>(proc).decodeCache().hits();
+}
+
+
+/**
+ * Get the number of decoding requests that have required
+ * the GLISS decoder.
+ * @return	Decode cache misses.
+ */
+t::uint64 Info::decodeMisses(void) const {
+	return static_cast<const Process&>(proc).decodeCache().misses();
+}
+
+
+/**
+ * Get the memory used by the instruction arena of the process
+ * (instructions and register tables).
+ * @return	Used bytes.
+ */
+t::uint64 Info::arenaBytes(void) const {
+	return static_cast<const Process&>(proc).instArena().bytes();
+}
+
+
+/**
+ * Get the number of objects allocated in the instruction arena.
+ * @return	Object count.
+ */
+t::uint64 Info::arenaObjects(void) const {
+	return static_cast<const Process&>(proc).instArena().objects();
+}
+
+
+/**
+ * Get the memory used to store the semantic instructions
+ * of the instructions.
+ * @return	Used bytes.
+ */
+t::uint64 Info::semBytes(void) const {
+	return static_cast<const Process&>(proc).semArena().bytes();
+}
+
+
+/**
+ * Get the number of non-empty semantic blocks stored in the cache.
+ * @return	Block count.
+ */
+t::uint64 Info::semBlocks(void) const {
+	return static_cast<const Process&>(proc).semArena().objects();
+}
+
+
+/**
+ * Find the function containing the given address.
+ * @param addr	Looked address.
+ * @return		Symbol of the function or null.
+ */
+Symbol *Info::functionAt(const Address& addr) const {
+	return static_cast<const Process&>(proc).functionAt(addr);
+}
+
+
+/**
+ * Get the size of the function starting at the given address, as given
+ * by its ELF symbol: it covers the whole function, including the code
+ * not reachable from its entry.
+ * @param addr	Function address.
+ * @return		Function size or 0 if unknown.
+ */
+ot::size Info::functionSize(const Address& addr) const {
+	return static_cast<const Process&>(proc).functionSize(addr);
+}
+
+
+/**
+ * Find the nearest symbol (function or label) at or before
+ * the given address.
+ * @param addr	Looked address.
+ * @return		Found symbol or null.
+ */
+Symbol *Info::symbolAt(const Address& addr) const {
+	return static_cast<const Process&>(proc).symbolAt(addr);
+}
+
+
+/**
+ * Get the kind of stack cache control performed by an instruction.
+ * @param inst	Instruction to look at.
+ * @return		Stack cache control kind (STACK_NONE for other instructions).
+ */
+stack_kind_t Info::stackKind(otawa::Inst *inst) {
+	return stack_kind_t(static_cast<Process&>(proc).decodeStack(inst->address()) & 0x7);
+}
+
+
+/**
+ * Get the amount, in bytes, of the stack cache control performed by an instruction.
+ * @param inst	Instruction to look at.
+ * @return		Amount in bytes or -1 if it is given by a register.
+ */
+int Info::stackAmount(otawa::Inst *inst) {
+	t::uint32 c = static_cast<Process&>(proc).decodeStack(inst->address());
+	if(c & 0x8)
+		return -1;
+	return c >> 4;
+}
+
+
+/**
+ * Get the class of the memory access performed by an instruction,
+ * as encoded in the opcode of loads and stores.
+ * @param inst	Instruction to look at.
+ * @return		Access class (ACCESS_NONE for other instructions).
+ */
+access_t Info::accessClass(otawa::Inst *inst) {
+	if(!inst->isMem())
+		return ACCESS_NONE;
+	return access_t(static_cast<Process&>(proc).decodeAccess(inst->address()) & 0xf);
+}
+
+
+/**
+ * Get the size, in bytes, of the memory access performed by an instruction.
+ * @param inst	Instruction to look at.
+ * @return		Access size (0 for other instructions).
+ */
+int Info::accessSize(otawa::Inst *inst) {
+	if(!inst->isMem())
+		return 0;
+	return static_cast<Process&>(proc).decodeAccess(inst->address()) >> 4;
+}
+
+
+/**
+ * Get the mask of registers read by an instruction.
+ * The bits of the mask are laid out as follows: R registers from
+ * @ref REG_MASK_R, S registers from @ref REG_MASK_S, P registers from
+ * @ref REG_MASK_P and the MCB register at @ref REG_MASK_MCB.
+ * @param inst	Instruction (must come from the Patmos process).
+ * @return		Read register mask.
+ */
+reg_mask_t Info::readMask(otawa::Inst *inst) {
+	return static_cast<Inst *>(inst)->readMask();
+}
+
+
+/**
+ * Get the mask of registers written by an instruction.
+ * @param inst	Instruction (must come from the Patmos process).
+ * @return		Written register mask.
+ * @see Info::readMask()
+ */
+reg_mask_t Info::writeMask(otawa::Inst *inst) {
+	return static_cast<Inst *>(inst)->writeMask();
+}
+
+
+/**
+ * Get the register matching a bit of a register mask.
+ * @param bit	Bit number.
+ * @return		Matching register or null.
+ */
+hard::Register *Info::maskRegister(int bit) const {
+	return register_decoder.maskRegister(bit);
+}
+
+
+/**
+ * Get the bit representing a register in the register masks.
+ * @param reg	Register to look for.
+ * @return		Bit number or -1 if the register is not represented.
+ */
+int Info::maskBit(const hard::Register *reg) const {
+	return register_decoder.maskBit(reg);
+}
+
+
 /**
  * Provide access to @ref Info data structure.
  * 
@@ -834,6 +2343,42 @@ Identifier<Info *> INFO("otawa::patmos::INFO", 0);
  */
 Feature<NoProcessor> INFO_FEATURE("otawa::patmos::INFO_FEATURE");
 
+
+/**
+ * Configuration of the loader giving the number of entries of the decode
+ * cache (rounded to the upper power of 2). A bigger cache decreases
+ * the number of calls to the GLISS decoder at the cost of memory.
+ *
+ * @p Hooks
+ * @li Configuration of the Process
+ */
+Identifier<int> DECODE_CACHE_SIZE("otawa::patmos::DECODE_CACHE_SIZE", 4096);
+
+
+/**
+ * Configuration of the loader asking to pre-decode all instructions
+ * of the executable sections at load time. The instruction information
+ * (kind, size, bundle, branch target, delay slots and used registers)
+ * is then read from flat tables instead of invoking the decoder.
+ *
+ * @p Hooks
+ * @li Configuration of the Process
+ */
+Identifier<bool> PREDECODE("otawa::patmos::PREDECODE", false);
+
+
+/**
+ * Configuration of the loader asking to map the ELF file in memory
+ * instead of loading it in the GLISS memory. Sections, symbols and
+ * memory reads are then served directly from the mapping and only
+ * the code is copied to the GLISS memory (as required by the decoder).
+ * The full GLISS platform is loaded only when simulation is required.
+ *
+ * @p Hooks
+ * @li Configuration of the Process
+ */
+Identifier<bool> MAP_FILE("otawa::patmos::MAP_FILE", false);
+
 } }	// otawa::patmos
 
 // Semantics information - Generic functions and constants
@@ -891,10 +2436,27 @@ Feature<NoProcessor> INFO_FEATURE("otawa::patmos::INFO_FEATURE");
 namespace otawa { namespace patmos {
 
 void Process::getSem(::otawa::Inst *oinst, ::otawa::sem::Block& block) {
-	patmos_inst_t *inst;
-	inst = patmos_decode(_patmosDecoder, oinst->address().offset());
-	patmos_sem(inst, block);
-	patmos_free_inst(inst);
+	patmos_sem(decodeInst(oinst->address()), block);
+}
+
+
+/**
+ * Compute the semantic instructions of an instruction and store them
+ * in the semantic arena. As the stored block is never modified,
+ * it may be copied each time the semantics of the instruction is required.
+ * @param oinst		Instruction to translate.
+ * @param ops		Returned semantic instructions.
+ * @return			Number of semantic instructions.
+ */
+int Process::decodeSem(::otawa::Inst *oinst, ::otawa::sem::inst *& ops) {
+	sem::Block block;
+	getSem(oinst, block);
+	ops = 0;
+	if(block.count())
+		ops = static_cast<sem::inst *>(sem_arena.allocate(block.count() * sizeof(sem::inst)));
+	for(int i = 0; i < block.count(); i++)
+		new(ops + i) sem::inst(block[i]);
+	return block.count();
 }
 
 } }	// namespace otawa::patmos
@@ -4,24 +4,131 @@
 #ifndef OTAWA_PATMOS_H
 #define OTAWA_PATMOS_H
 
+#include <elm/genstruct/Vector.h>
 #include <otawa/proc/Feature.h>
+#include <otawa/hard/Register.h>
+#include <otawa/prog/Symbol.h>
+#include <otawa/proc/Processor.h>
+#include <elm/sys/Path.h>
 
 namespace otawa { namespace patmos {
 
 using namespace elm;
 using namespace otawa;
 
+// register masks
+typedef t::uint64 reg_mask_t;
+const int
+	REG_MASK_R		= 0,	// 32 R registers
+	REG_MASK_S		= 32,	// 16 S registers
+	REG_MASK_P		= 48,	// 8 P registers
+	REG_MASK_MCB	= 56,	// MCB register
+	REG_MASK_SIZE	= 57;
+
+// stack cache control
+typedef enum {
+	STACK_NONE = 0,
+	STACK_RES = 1,		// sres
+	STACK_ENS = 2,		// sens
+	STACK_FREE = 3,		// sfree
+	STACK_SPILL = 4		// sspill
+} stack_kind_t;
+
+// memory access class
+typedef enum {
+	ACCESS_NONE = 0,
+	ACCESS_STACK = 1,		// through the stack cache
+	ACCESS_CACHE = 2,		// through the data cache
+	ACCESS_BYPASS = 3,		// main memory, bypassing the caches
+	ACCESS_LOCAL = 4		// local scratchpad memory
+} access_t;
+
+class BundleMap;
+
 class Info {
 public:
 	Info(Process& _proc);
+	~Info(void);
+
+	// bundle access
 	int bundleSize(const Address& addr);
+	bool isBundleStart(const Address& addr);
+	bool hasBundleMap(const Address& addr) const;
+	Address nextBundle(const Address& addr);
+	void addBundleMap(const Address& base, t::uint32 size);
+
+	// symbols
+	Symbol *functionAt(const Address& addr) const;
+	Symbol *symbolAt(const Address& addr) const;
+	ot::size functionSize(const Address& addr) const;
+
+	// register usage
+	reg_mask_t readMask(otawa::Inst *inst);
+	reg_mask_t writeMask(otawa::Inst *inst);
+	hard::Register *maskRegister(int bit) const;
+	int maskBit(const hard::Register *reg) const;
+
+	// stack cache control
+	stack_kind_t stackKind(otawa::Inst *inst);
+	int stackAmount(otawa::Inst *inst);
+
+	// memory access class
+	access_t accessClass(otawa::Inst *inst);
+	int accessSize(otawa::Inst *inst);
+
+	// decode cache statistics
+	t::uint64 decodeHits(void) const;
+	t::uint64 decodeMisses(void) const;
+
+	// instruction arena statistics
+	t::uint64 arenaBytes(void) const;
+	t::uint64 arenaObjects(void) const;
+
+	// semantic cache statistics
+	t::uint64 semBytes(void) const;
+	t::uint64 semBlocks(void) const;
+
 private:
+	BundleMap *mapFor(const Address& addr) const;
 	Process& proc;
+	genstruct::Vector<BundleMap *> maps;
 };
 
 extern Identifier<Info *> INFO;
 extern Feature<NoProcessor> INFO_FEATURE;
 
+// PML flow facts
+class FlowConstraint {
+public:
+	typedef enum {
+		LE = 0,
+		EQ = 1,
+		GE = 2
+	} op_t;
+
+	// a null block counts the calls to the function,
+	// a non-null target counts the edge from block to target
+	typedef struct {
+		int factor;
+		Address function, block, target;
+	} term_t;
+
+	Address function, loop;		// scope (loop is null for a function scope)
+	op_t op;
+	int rhs;
+	genstruct::Vector<term_t> terms;
+};
+
+extern Identifier<sys::Path> PML_PATH;
+extern Identifier<genstruct::Vector<FlowConstraint *> *> FLOW_CONSTRAINTS;
+extern p::feature PML_FACTS_FEATURE;
+extern p::feature PML_CONSTRAINT_FEATURE;
+
+// configuration
+extern Identifier<int> DECODE_CACHE_SIZE;
+extern Identifier<bool> PREDECODE;
+extern Identifier<bool> MAP_FILE;
+
 } } // otawa::patmos
 
 #endif // OTAWA_PATMOS_H
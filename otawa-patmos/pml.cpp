@@ -0,0 +1,697 @@
+/*
+ *	PML flow fact importer
+ */
+
+#include <elm/assert.h>
+#include <elm/genstruct/HashTable.h>
+#include <elm/string/StringBuffer.h>
+#include <otawa/prog/WorkSpace.h>
+#include <otawa/util/FlowFactLoader.h>
+#include <otawa/cfg/features.h>
+#include <otawa/ipet/features.h>
+#include <otawa/ilp/System.h>
+#include <otawa/ilp/Constraint.h>
+#include "patmos.h"
+
+#include <algorithm>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+namespace otawa { namespace patmos {
+
+/**
+ * Streaming reader for the block-style YAML subset used by PML files.
+ * The file is read line by line and only the path of keys leading to the
+ * current line is kept, so memory use does not depend on the file size.
+ * Flow collections (like "[ 1, 2 ]") are returned as plain scalars.
+ */
+class YAMLReader {
+public:
+	typedef enum {
+		END = 0,	// end of file
+		DOC,		// document separator ("---" or "...")
+		ITEM,		// new item of the sequence at top of the path
+		KEY			// key at top of the path with its value (possibly empty)
+	} event_t;
+	static const int KEY_SIZE = 32;
+
+	YAMLReader(FILE *file): f(file), buf(0), cap(0), _line(0), pending(0), _value("") { }
+	~YAMLReader(void) { free(buf); }
+
+	/**
+	 * Read the next event.
+	 * @return	Read event.
+	 */
+	event_t next(void) {
+		if(pending) {
+			char *p = pending;
+			pending = 0;
+			return key(p, separator(p));
+		}
+		while(true) {
+			ssize_t n = getline(&buf, &cap, f);
+			if(n < 0)
+				return END;
+			_line++;
+			while(n > 0 && (buf[n - 1] == '\n' || buf[n - 1] == '\r' || buf[n - 1] == ' ' || buf[n - 1] == '\t'))
+				buf[--n] = '\0';
+			if(strncmp(buf, "---", 3) == 0 || strncmp(buf, "...", 3) == 0) {
+				path.clear();
+				return DOC;
+			}
+			char *p = buf;
+			while(*p == ' ')
+				p++;
+			if(!*p || *p == '#')
+				continue;
+
+			// sequence item, possibly followed by its first key
+			if(p[0] == '-' && (p[1] == ' ' || !p[1])) {
+				pop(p - buf, false);
+				for(p++; *p == ' '; p++) ;
+				if(separator(p)) {
+					pending = p;
+					_value = "";
+				}
+				else
+					_value = unquote(p);
+				return ITEM;
+			}
+
+			// key, other lines (multi-line scalars) are ignored
+			char *s = separator(p);
+			if(s)
+				return key(p, s);
+		}
+	}
+
+	inline int depth(void) const { return path.length(); }
+	inline cstring at(int i) const { return path[i].key; }
+	inline bool is(int i, cstring key) const { return i < path.length() && at(i) == key; }
+	inline cstring value(void) const { return _value; }
+	inline int line(void) const { return _line; }
+
+private:
+	typedef struct {
+		int col;
+		char key[KEY_SIZE];
+	} entry_t;
+
+	event_t key(char *p, char *s) {
+		ASSERT(s);
+		pop(p - buf, true);
+		*s = '\0';
+		entry_t e;
+		e.col = p - buf;
+		strncpy(e.key, p, KEY_SIZE - 1);
+		e.key[KEY_SIZE - 1] = '\0';
+		path.add(e);
+		for(s++; *s == ' '; s++) ;
+		_value = unquote(s);
+		return KEY;
+	}
+
+	void pop(int col, bool same) {
+		while(!path.isEmpty() && (path.top().col > col || (same && path.top().col == col)))
+			path.pop();
+	}
+
+	static char *separator(char *p) {
+		if(*p == '\'' || *p == '"')
+			return 0;
+		for(; *p; p++)
+			if(*p == ':' && (p[1] == ' ' || !p[1]))
+				return p;
+		return 0;
+	}
+
+	static char *unquote(char *p) {
+		int n = strlen(p);
+		if(n >= 2 && (p[0] == '\'' || p[0] == '"') && p[n - 1] == p[0]) {
+			p[n - 1] = '\0';
+			return p + 1;
+		}
+		return p;
+	}
+
+	FILE *f;
+	char *buf;
+	size_t cap;
+	int _line;
+	char *pending;
+	cstring _value;
+	genstruct::Vector<entry_t> path;
+};
+
+
+/**
+ * Release the flow constraints of a workspace
+ * when @ref PML_FACTS_FEATURE is invalidated.
+ */
+class ConstraintCleaner: public Cleaner {
+public:
+	ConstraintCleaner(WorkSpace *_ws): ws(_ws) { }
+
+	virtual void clean(void) {
+		genstruct::Vector<FlowConstraint *> *cons = FLOW_CONSTRAINTS(ws);
+		if(!cons)
+			return;
+		for(int i = 0; i < cons->count(); i++)
+			delete cons->get(i);
+		delete cons;
+		FLOW_CONSTRAINTS(ws).remove();
+	}
+
+private:
+	WorkSpace *ws;
+};
+
+
+/**
+ * Importer of the flow facts of a PML file produced by the Patmos compiler.
+ *
+ * The file is streamed in one pass. Only the flow facts of level machinecode
+ * are imported. Their blocks are mapped to addresses through the ELF symbols
+ * the compiler emits for machine basic blocks (".LBB<function>_<block>").
+ * If a symbol is missing, the "address" of the block in the machine-functions
+ * is used, or the "mapsto" label of the function for block 0.
+ *
+ * A loop-scoped fact that bounds the header of its own loop is a loop bound and
+ * is installed as @ref otawa::MAX_ITERATION on the first instruction of the header
+ * (the tightest bound is kept). The other facts are recorded as @ref FlowConstraint
+ * in @ref FLOW_CONSTRAINTS. Facts with contexts, symbolic right-hand sides or
+ * unresolved blocks are ignored.
+ *
+ * @p Configuration
+ * @li @ref PML_PATH
+ *
+ * @p Provided features
+ * @li @ref PML_FACTS_FEATURE
+ */
+class PMLImporter: public Processor {
+public:
+	static p::declare reg;
+	PMLImporter(p::declare& r = reg): Processor(r), ws(0), cons(0), state(NONE),
+		in_fact(false), bad(false), fact_line(0), bounds(0), facts(0), ignored(0) { }
+
+protected:
+
+	virtual void configure(const PropList& props) {
+		Processor::configure(props);
+		explicit_path = !PML_PATH(props).toString().isEmpty();
+		if(explicit_path)
+			path = PML_PATH(props);
+	}
+
+	virtual void processWorkSpace(WorkSpace *_ws) {
+		ws = _ws;
+		cons = new genstruct::Vector<FlowConstraint *>();
+		FLOW_CONSTRAINTS(ws) = cons;
+		addCleaner(PML_FACTS_FEATURE, new ConstraintCleaner(ws));
+		bounds = 0;
+		facts = 0;
+		ignored = 0;
+
+		// open the file
+		sys::Path p = path;
+		if(!explicit_path)
+			p = sys::Path(ws->process()->program()->name()).setExtension("pml");
+		FILE *f = fopen(p.toString().toCString().chars(), "r");
+		if(!f) {
+			if(explicit_path)
+				throw ProcessorException(*this, _ << "cannot open PML file " << p);
+			if(logFor(LOG_DEPS))
+				log << "\tno PML file " << p << io::endl;
+			return;
+		}
+		setvbuf(f, 0, _IOFBF, 1 << 16);
+
+		// stream the file
+		YAMLReader r(f);
+		state = NONE;
+		for(YAMLReader::event_t e = r.next(); e != YAMLReader::END; e = r.next())
+			switch(e) {
+			case YAMLReader::DOC:
+				flush();
+				state = NONE;
+				break;
+			case YAMLReader::ITEM:
+				onItem(r);
+				break;
+			case YAMLReader::KEY:
+				onKey(r);
+				break;
+			default:
+				break;
+			}
+		flush();
+		fclose(f);
+		labels.clear();
+		addrs.clear();
+
+		if(logFor(LOG_DEPS))
+			log << "\t" << p << ": " << facts << " flow facts, " << bounds << " loop bounds, "
+				<< cons->count() << " constraints, " << ignored << " ignored" << io::endl;
+	}
+
+private:
+	typedef enum {
+		NONE = 0,
+		FUNCTION,
+		FACT
+	} state_t;
+
+	typedef struct {
+		int factor;
+		String function, block, source, target;
+	} point_t;
+
+	void onItem(const YAMLReader& r) {
+		int d = r.depth();
+		if(d == 1) {
+			flush();
+			if(r.is(0, "machine-functions"))
+				state = FUNCTION;
+			else if(r.is(0, "flowfacts")) {
+				state = FACT;
+				startFact(r.line());
+			}
+			else
+				state = NONE;
+		}
+		else if(d == 2 && state == FUNCTION && r.is(1, "blocks"))
+			commitBlock();
+		else if(d == 2 && state == FACT && r.is(1, "lhs")) {
+			point_t p;
+			p.factor = 1;
+			points.add(p);
+		}
+	}
+
+	void onKey(const YAMLReader& r) {
+		int d = r.depth();
+		if(d == 1) {
+			flush();
+			state = NONE;
+		}
+
+		// machine function: name, label and block addresses
+		else if(state == FUNCTION) {
+			if(d == 2) {
+				if(r.is(1, "name"))
+					fun = r.value();
+				else if(r.is(1, "mapsto"))
+					label = r.value();
+			}
+			else if(d == 3 && r.is(1, "blocks")) {
+				if(r.is(2, "name"))
+					block = r.value();
+				else if(r.is(2, "address"))
+					addr = Address(t::uint32(strtoul(r.value().chars(), 0, 0)));
+			}
+		}
+
+		// flow fact
+		else if(state == FACT) {
+			if(d == 2) {
+				if(r.is(1, "op"))
+					op = r.value();
+				else if(r.is(1, "rhs"))
+					rhs = r.value();
+				else if(r.is(1, "level"))
+					level = r.value();
+			}
+			else if(d == 3 && r.is(1, "scope")) {
+				if(r.is(2, "function"))
+					scope_fun = r.value();
+				else if(r.is(2, "loop"))
+					scope_loop = r.value();
+				else
+					bad = true;
+			}
+			else if(d == 3 && r.is(1, "lhs") && !points.isEmpty()) {
+				if(r.is(2, "factor"))
+					points.top().factor = strtol(r.value().chars(), 0, 10);
+			}
+			else if(d == 4 && r.is(1, "lhs") && r.is(2, "program-point") && !points.isEmpty()) {
+				point_t& p = points.top();
+				if(r.is(3, "function"))
+					p.function = r.value();
+				else if(r.is(3, "block"))
+					p.block = r.value();
+				else if(r.is(3, "edgesource"))
+					p.source = r.value();
+				else if(r.is(3, "edgetarget"))
+					p.target = r.value();
+				else
+					bad = true;
+			}
+		}
+	}
+
+	void flush(void) {
+		commitBlock();
+		commitFunction();
+		commitFact();
+	}
+
+	void commitBlock(void) {
+		if(fun && block && !addr.isNull())
+			addrs.put(symbol(fun, block), addr);
+		block = "";
+		addr = Address::null;
+	}
+
+	void commitFunction(void) {
+		if(fun && label)
+			labels.put(fun, label);
+		fun = "";
+		label = "";
+	}
+
+	void startFact(int line) {
+		in_fact = true;
+		bad = false;
+		fact_line = line;
+		scope_fun = "";
+		scope_loop = "";
+		op = "";
+		rhs = "";
+		level = "";
+		points.clear();
+	}
+
+	void commitFact(void) {
+		if(!in_fact)
+			return;
+		in_fact = false;
+		facts++;
+		if(level != "machinecode")
+			return ignore(0);
+		if(bad || !scope_fun || points.isEmpty())
+			return ignore("unsupported flow fact");
+
+		// right-hand side and operator
+		char *e;
+		CString s = rhs.toCString();
+		long n = strtol(s.chars(), &e, 10);
+		if(!rhs || *e)
+			return ignore("symbolic right-hand side");
+		FlowConstraint::op_t o;
+		if(op == "less-equal")
+			o = FlowConstraint::LE;
+		else if(op == "equal")
+			o = FlowConstraint::EQ;
+		else if(op == "greater-equal")
+			o = FlowConstraint::GE;
+		else
+			return ignore("unknown operator");
+
+		// scope
+		Address f = resolve(scope_fun, "0"), l;
+		if(f.isNull())
+			return ignore("unresolved scope function");
+		if(scope_loop) {
+			l = resolve(scope_fun, scope_loop);
+			if(l.isNull())
+				return ignore("unresolved scope loop");
+		}
+
+		// loop bound
+		if(!l.isNull() && o == FlowConstraint::LE && points.count() == 1) {
+			const point_t& p = points[0];
+			if(p.factor == 1 && p.function == scope_fun && p.block == scope_loop && !p.source) {
+				Inst *inst = ws->process()->findInstAt(l);
+				if(!inst)
+					return ignore("no instruction at loop header");
+				if(MAX_ITERATION(inst) < 0 || n < MAX_ITERATION(inst))
+					MAX_ITERATION(inst) = n;
+				bounds++;
+				return;
+			}
+		}
+
+		// linear constraint
+		FlowConstraint *c = new FlowConstraint();
+		c->function = f;
+		c->loop = l;
+		c->op = o;
+		c->rhs = n;
+		for(int i = 0; i < points.count(); i++) {
+			const point_t& p = points[i];
+			FlowConstraint::term_t t;
+			t.factor = p.factor;
+			t.function = resolve(p.function, "0");
+			if(p.block)
+				t.block = resolve(p.function, p.block);
+			else if(p.source) {
+				t.block = resolve(p.function, p.source);
+				if(p.target)
+					t.target = resolve(p.function, p.target);
+			}
+			if(t.function.isNull() || (p.block && t.block.isNull())
+			|| (p.source && (!p.target || t.block.isNull() || t.target.isNull()))) {
+				delete c;
+				return ignore("unresolved program point");
+			}
+			c->terms.add(t);
+		}
+		cons->add(c);
+	}
+
+	void ignore(const char *reason) {
+		ignored++;
+		if(reason && logFor(LOG_DEPS))
+			log << "\tline " << fact_line << ": " << reason << ", flow fact ignored" << io::endl;
+	}
+
+	/**
+	 * Find the address of a block of a machine function.
+	 * @param fun	Machine function name.
+	 * @param block	Block name.
+	 * @return		Block address or null.
+	 */
+	Address resolve(const String& fun, const String& block) {
+		String name = symbol(fun, block);
+		Address a = ws->process()->findLabel(name);
+		if(a.isNull())
+			a = addrs.get(name, Address::null);
+		if(a.isNull() && block == "0") {
+			String l = labels.get(fun, "");
+			if(l)
+				a = ws->process()->findLabel(l);
+		}
+		return a;
+	}
+
+	static String symbol(const String& fun, const String& block) {
+		StringBuffer buf;
+		buf << ".LBB" << fun << '_' << block;
+		return buf.toString();
+	}
+
+	sys::Path path;
+	bool explicit_path;
+	WorkSpace *ws;
+	genstruct::Vector<FlowConstraint *> *cons;
+	state_t state;
+
+	// machine functions
+	genstruct::HashTable<String, String> labels;
+	genstruct::HashTable<String, Address> addrs;
+	String fun, label, block;
+	Address addr;
+
+	// current flow fact
+	bool in_fact, bad;
+	int fact_line;
+	String scope_fun, scope_loop, op, rhs, level;
+	genstruct::Vector<point_t> points;
+
+	// statistics
+	int bounds, facts, ignored;
+};
+
+p::feature PML_FACTS_FEATURE("otawa::patmos::PML_FACTS_FEATURE", new Maker<PMLImporter>());
+
+p::declare PMLImporter::reg = p::init("otawa::patmos::PMLImporter", Version(1, 0, 0))
+	.base(Processor::reg)
+	.maker<PMLImporter>()
+	.provide(PML_FACTS_FEATURE);
+
+
+/**
+ * Builder of the ILP constraints of the flow constraints imported
+ * from a PML file. With x the execution counts, each constraint
+ * sum(factor * x[term]) op rhs * x[scope] is added where x[scope]
+ * is the count of calls to the function of the scope or the count of
+ * entries in the loop of the scope. An edge term counts the edge leaving
+ * the last part of its source machine block, as OTAWA splits the machine
+ * blocks after the calls. Constraints whose blocks are not found in the CFGs
+ * are skipped.
+ *
+ * @p Required features
+ * @li @ref PML_FACTS_FEATURE
+ *
+ * @p Provided features
+ * @li @ref PML_CONSTRAINT_FEATURE
+ */
+class PMLConstraintBuilder: public Processor {
+public:
+	static p::declare reg;
+	PMLConstraintBuilder(p::declare& r = reg): Processor(r) { }
+
+protected:
+
+	virtual void processWorkSpace(WorkSpace *ws) {
+		genstruct::Vector<FlowConstraint *> *cons = FLOW_CONSTRAINTS(ws);
+		if(!cons || !cons->count())
+			return;
+
+		// index the blocks by function and address
+		const CFGCollection *coll = INVOLVED_CFGS(ws);
+		ASSERT(coll);
+		blocks.clear();
+		for(int i = 0; i < coll->count(); i++)
+			for(CFG::BBIterator bb(coll->get(i)); bb; bb++)
+				if(!bb->isEnd()) {
+					entry_t e = { coll->get(i)->address().offset(), bb->address().offset(), coll->get(i), bb };
+					blocks.add(e);
+				}
+		if(blocks.isEmpty())
+			return;
+		std::sort(&blocks[0], &blocks[0] + blocks.count(), less);
+
+		// build the constraints
+		ilp::System *sys = ipet::SYSTEM(ws);
+		int added = 0;
+		for(int i = 0; i < cons->count(); i++)
+			if(build(sys, cons->get(i)))
+				added++;
+		if(logFor(LOG_DEPS))
+			log << "\t" << added << " PML constraints added, " << (cons->count() - added) << " skipped" << io::endl;
+	}
+
+private:
+	typedef struct {
+		t::uint32 fun, addr;
+		CFG *cfg;
+		BasicBlock *bb;
+	} entry_t;
+
+	typedef struct {
+		int factor;
+		ilp::Var *var;
+	} term_t;
+
+	static bool less(const entry_t& e1, const entry_t& e2)
+		{ return e1.fun < e2.fun || (e1.fun == e2.fun && e1.addr < e2.addr); }
+
+	const entry_t *find(const Address& fun, const Address& addr) {
+		entry_t k = { fun.offset(), addr.offset(), 0, 0 };
+		const entry_t *end = &blocks[0] + blocks.count(), *e = std::lower_bound(&blocks[0], end, k, less);
+		if(e == end || e->fun != k.fun || e->addr != k.addr)
+			return 0;
+		return e;
+	}
+
+	/**
+	 * Get the next part of a machine block split by OTAWA after a call:
+	 * the edges of the machine block leave its last part.
+	 * @param e		Current part.
+	 * @return		Next part or null if the current one is the last.
+	 */
+	const entry_t *next(const entry_t *e) {
+		for(BasicBlock::OutIterator edge(e->bb); edge; edge++)
+			if(edge->kind() == Edge::CALL || edge->kind() == Edge::VIRTUAL_CALL)
+				return find(Address(e->fun), e->bb->topAddress());
+		return 0;
+	}
+
+	bool build(ilp::System *sys, FlowConstraint *c) {
+
+		// scope: not involved function does not constrain anything
+		const entry_t *s = find(c->function, c->loop.isNull() ? c->function : c->loop);
+		if(!s || (!c->loop.isNull() && !LOOP_HEADER(s->bb)))
+			return false;
+
+		// look for the variables of the terms
+		genstruct::Vector<term_t> terms;
+		for(int i = 0; i < c->terms.count(); i++) {
+			const FlowConstraint::term_t& t = c->terms[i];
+			const entry_t *e = find(t.function, t.block.isNull() ? t.function : t.block);
+			if(!e)
+				return false;
+			term_t r = { t.factor, 0 };
+			if(t.block.isNull())
+				r.var = ipet::VAR(e->cfg->entry());
+			else if(t.target.isNull())
+				r.var = ipet::VAR(e->bb);
+			else
+				for(const entry_t *p = e; p && !r.var; p = next(p))
+					for(BasicBlock::OutIterator edge(p->bb); edge; edge++)
+						if(edge->kind() != Edge::CALL && edge->target() && edge->target()->address() == t.target)
+							r.var = ipet::VAR(edge);
+			if(!r.var)
+				return false;
+			terms.add(r);
+		}
+
+		// build the constraint
+		ilp::Constraint::comparator_t comp = c->op == FlowConstraint::LE ? ilp::Constraint::LE
+			: c->op == FlowConstraint::GE ? ilp::Constraint::GE : ilp::Constraint::EQ;
+		ilp::Constraint *cons = sys->newConstraint("PML flow fact", comp);
+		for(int i = 0; i < terms.count(); i++)
+			cons->addLeft(terms[i].factor, terms[i].var);
+		if(c->rhs) {
+			if(c->loop.isNull())
+				cons->addRight(c->rhs, ipet::VAR(s->cfg->entry()));
+			else
+				for(BasicBlock::InIterator edge(s->bb); edge; edge++)
+					if(!BACK_EDGE(edge))
+						cons->addRight(c->rhs, ipet::VAR(edge));
+		}
+		return true;
+	}
+
+	genstruct::Vector<entry_t> blocks;
+};
+
+p::feature PML_CONSTRAINT_FEATURE("otawa::patmos::PML_CONSTRAINT_FEATURE", new Maker<PMLConstraintBuilder>());
+
+p::declare PMLConstraintBuilder::reg = p::init("otawa::patmos::PMLConstraintBuilder", Version(1, 0, 0))
+	.base(Processor::reg)
+	.maker<PMLConstraintBuilder>()
+	.require(PML_FACTS_FEATURE)
+	.require(COLLECTED_CFG_FEATURE)
+	.require(LOOP_HEADERS_FEATURE)
+	.require(ipet::ILP_SYSTEM_FEATURE)
+	.require(ipet::ASSIGNED_VARS_FEATURE)
+	.provide(PML_CONSTRAINT_FEATURE);
+
+
+/**
+ * Path of the PML file to import flow facts from. If it is given, the file
+ * must exist; else the path of the program with the extension ".pml" is used,
+ * ignored if it does not exist.
+ *
+ * @p Hooks
+ * @li Configuration of @ref PML_FACTS_FEATURE
+ */
+Identifier<sys::Path> PML_PATH("otawa::patmos::PML_PATH", "");
+
+
+/**
+ * Linear flow constraints imported from a PML file (loop bounds
+ * are installed as @ref otawa::MAX_ITERATION instead).
+ *
+ * @p Features
+ * @li @ref PML_FACTS_FEATURE
+ *
+ * @p Hooks
+ * @li WorkSpace
+ */
+Identifier<genstruct::Vector<FlowConstraint *> *> FLOW_CONSTRAINTS("otawa::patmos::FLOW_CONSTRAINTS", 0);
+
+} }	// otawa::patmos
@@ -0,0 +1,42 @@
+/* Generated by gliss-attr ($(date)) copyright (c) 2009 IRIT - UPS */
+
+#include <$(proc)/api.h>
+#include <$(proc)/id.h>
+#include <$(proc)/macros.h>
+
+typedef unsigned long (*stack_fun_t)($(proc)_inst_t *inst);
+
+
+
+static unsigned long otawa_stack_UNKNOWN($(proc)_inst_t *inst)
+{
+        /* this code should also be used as default value if
+        an instruction has no otawa_stack field */
+        return 0;
+}
+
+$(foreach instructions)
+static unsigned long otawa_stack_$(IDENT)($(proc)_inst_t *inst) {
+$(otawa_stack)
+};
+
+$(end)
+
+
+/* function table */
+static stack_fun_t $(proc)_stack_table[] =
+{
+	otawa_stack_UNKNOWN$(foreach instructions),
+	otawa_stack_$(IDENT)$(end)
+};
+
+
+
+/**
+ * Get the stack cache control of the instruction.
+ * @return Stack cache control (kind, dynamic flag and amount).
+ */
+unsigned long $(proc)_stack($(proc)_inst_t *inst)
+{
+        return $(proc)_stack_table[inst->ident](inst);
+}
@@ -0,0 +1,166 @@
+/*
+ * License HERE!
+ */
+
+#include <otawa/proc/BBProcessor.h>
+#include <otawa/dcache/features.h>
+#include <otawa/ilp/features.h>
+#include <otawa/ipet/features.h>
+#include <otawa/ilp/System.h>
+#include <otawa/hard/Memory.h>
+#include <otawa/hard/CacheConfiguration.h>
+#include <otawa/cfg/features.h>
+#include "../otawa-patmos/patmos.h"
+
+namespace tcrest { namespace patmos {
+
+using namespace otawa;
+
+extern Identifier<ot::time> CACHE_TIME;
+
+/**
+ * Filter of the data accesses of the data cache analysis.
+ *
+ * Patmos encodes the accessed memory in the opcode of loads and stores:
+ * only the accesses through the data cache are kept in the data blocks
+ * of otawa::dcache (otawa::dcache::DATA_BLOCKS) and the block collections
+ * (otawa::dcache::DATA_BLOCK_COLLECTION) are rebuilt from the kept accesses,
+ * so that the cache states only hold cached blocks. The other accesses get a fixed
+ * cost added to the objective function for each execution of their block:
+ *	- stack cache accesses cost nothing (spills and fills are supported
+ *	  by the stack cache analysis),
+ *	- local accesses cost the latency of the SPM bank of memory.xml,
+ *	- bypass accesses cost the latency of the DRAM bank of memory.xml.
+ */
+class AccessFilter: public BBProcessor {
+public:
+	static p::declare reg;
+	AccessFilter(p::declare& r = reg): BBProcessor(r), info(0), sys(0),
+		local_time(0), bypass_time(0), kept(0), removed(0) { }
+
+protected:
+
+	virtual void setup(WorkSpace *ws) {
+		info = otawa::patmos::INFO(ws->process());
+		ASSERT(info);
+		sys = ipet::SYSTEM(ws);
+		kept = 0;
+		removed = 0;
+
+		// look for the bank latencies
+		local_time = 0;
+		bypass_time = 0;
+		const hard::Memory& mem = ws->platform()->memory();
+		for(int i = 0; i < mem.banks().count(); i++) {
+			const hard::Bank *bank = mem.banks()[i];
+			if(bank->type() == hard::Bank::SPM)
+				local_time = max(local_time, ot::time(bank->latency()));
+			else if(bank->type() == hard::Bank::DRAM)
+				bypass_time = max(bypass_time, ot::time(bank->latency()));
+		}
+	}
+
+	virtual void cleanup(WorkSpace *ws) {
+
+		// rebuild the block collections from the kept accesses
+		// (the removed blocks would still take place in the cache states)
+		const hard::Cache *cache = hard::CACHE_CONFIGURATION(ws)->dataCache();
+		if(cache && removed) {
+			dcache::BlockCollection *colls = new dcache::BlockCollection[cache->setCount()];
+			for(int i = 0; i < cache->setCount(); i++)
+				colls[i].setSet(i);
+			const CFGCollection *coll = INVOLVED_CFGS(ws);
+			for(int i = 0; i < coll->count(); i++)
+				for(CFG::BBIterator bb(coll->get(i)); bb; bb++) {
+					if(bb->isEnd() || !dcache::DATA_BLOCKS(bb).exists())
+						continue;
+					Pair<int, dcache::BlockAccess *> blocks = dcache::DATA_BLOCKS(bb);
+					for(int j = 0; j < blocks.fst; j++)
+						if(blocks.snd[j].kind() == dcache::BlockAccess::BLOCK) {
+							const dcache::Block& block = blocks.snd[j].block();
+							blocks.snd[j] = dcache::BlockAccess(blocks.snd[j].instruction(), blocks.snd[j].action(),
+								colls[block.set()].obtain(block.address()));
+						}
+				}
+			delete [] dcache::DATA_BLOCK_COLLECTION(ws);
+			dcache::DATA_BLOCK_COLLECTION(ws) = colls;
+		}
+
+		if(logFor(LOG_DEPS))
+			log << "\tdata cache accesses: " << kept << " kept, " << removed << " removed" << io::endl;
+	}
+
+	virtual void processBB(WorkSpace *ws, CFG *cfg, BasicBlock *bb) {
+		if(bb->isEnd() || !dcache::DATA_BLOCKS(bb).exists())
+			return;
+		Pair<int, dcache::BlockAccess *> blocks = dcache::DATA_BLOCKS(bb);
+
+		// count the kept accesses and the fixed cost of the others
+		int cnt = 0;
+		ot::time time = 0;
+		for(int i = 0; i < blocks.fst; i++)
+			switch(info->accessClass(blocks.snd[i].instruction())) {
+			case otawa::patmos::ACCESS_CACHE:
+			case otawa::patmos::ACCESS_NONE:
+				cnt++;
+				break;
+			case otawa::patmos::ACCESS_LOCAL:
+				time += local_time;
+				break;
+			case otawa::patmos::ACCESS_BYPASS:
+				time += bypass_time;
+				break;
+			case otawa::patmos::ACCESS_STACK:
+				break;
+			}
+		kept += cnt;
+		removed += blocks.fst - cnt;
+		if(cnt == blocks.fst)
+			return;
+
+		// rebuild the accesses
+		dcache::BlockAccess *accs = 0;
+		if(cnt) {
+			accs = new dcache::BlockAccess[cnt];
+			for(int i = 0, j = 0; i < blocks.fst; i++) {
+				otawa::patmos::access_t a = info->accessClass(blocks.snd[i].instruction());
+				if(a == otawa::patmos::ACCESS_CACHE || a == otawa::patmos::ACCESS_NONE)
+					accs[j++] = blocks.snd[i];
+			}
+		}
+		delete [] blocks.snd;
+		dcache::DATA_BLOCKS(bb) = pair(cnt, accs);
+
+		// add the fixed cost
+		if(time) {
+			if(logFor(LOG_BB))
+				log << "\t\t" << bb << ": fixed access time = " << time << io::endl;
+			sys->addObjectFunction(double(time), ipet::VAR(bb));
+			CACHE_TIME(bb) = CACHE_TIME(bb) + time;
+		}
+	}
+
+private:
+	otawa::patmos::Info *info;
+	ilp::System *sys;
+	ot::time local_time, bypass_time;
+	int kept, removed;
+};
+
+
+/**
+ * Feature ensuring that the data blocks of otawa::dcache only contain
+ * the accesses performed through the data cache and that the other
+ * accesses have been given a fixed cost.
+ */
+p::feature DATA_ACCESS_FILTER_FEATURE("tcrest::patmos::DATA_ACCESS_FILTER_FEATURE", new Maker<AccessFilter>());
+
+p::declare AccessFilter::reg = p::init("tcrest::patmos::AccessFilter", Version(1, 0, 0))
+	.base(BBProcessor::reg)
+	.maker<AccessFilter>()
+	.require(dcache::DATA_BLOCK_FEATURE)
+	.require(ipet::ILP_SYSTEM_FEATURE)
+	.require(ipet::ASSIGNED_VARS_FEATURE)
+	.provide(DATA_ACCESS_FILTER_FEATURE);
+
+} }	// tcrest::patmos
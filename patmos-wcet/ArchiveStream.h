@@ -0,0 +1,39 @@
+/*
+ * License HERE!
+ */
+#ifndef TCREST_PATMOS_ARCHIVESTREAM_H
+#define TCREST_PATMOS_ARCHIVESTREAM_H
+
+#include <elm/io/OutStream.h>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+
+namespace tcrest { namespace patmos {
+
+using namespace elm;
+
+/**
+ * Output stream writing to a file through a big stdio buffer.
+ * It is used to stream big outputs (graph archives, PML results)
+ * without building them in memory.
+ */
+class ArchiveStream: public io::OutStream {
+public:
+	static const int BUFFER_SIZE = 256 * 1024;
+
+	ArchiveStream(FILE *file): f(file) { setvbuf(f, 0, _IOFBF, BUFFER_SIZE); }
+	~ArchiveStream(void) { fclose(f); }
+
+	virtual int write(const char *buffer, int size)
+		{ return fwrite(buffer, 1, size, f) == size_t(size) ? size : -1; }
+	virtual int flush(void) { return fflush(f); }
+	virtual CString lastErrorMessage(void) { return strerror(errno); }
+
+private:
+	FILE *f;
+};
+
+} }	// tcrest::patmos
+
+#endif	// TCREST_PATMOS_ARCHIVESTREAM_H
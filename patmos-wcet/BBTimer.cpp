@@ -5,12 +5,37 @@
 #include <otawa/parexegraph/GraphBBTime.h>
 #include <otawa/parexegraph/ParExeGraph.h>
 #include <otawa/cfg/features.h>
+#include <otawa/hard/Memory.h>
+#include <otawa/hard/CacheConfiguration.h>
 #include "../otawa-patmos/patmos.h"
+#include "ArchiveStream.h"
+#include <elm/string/StringBuffer.h>
+#include <elm/util/AutoPtr.h>
+#include <pthread.h>
+#include <new>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 
 namespace tcrest { namespace patmos {
 
 using namespace otawa;
 
+extern Identifier<int> THREADS;
+extern Identifier<int> PROLOGUE_WINDOW;
+extern Identifier<bool> CHECK_PROLOGUE_WINDOW;
+extern Identifier<string> GRAPHS_ARCHIVE;
+extern Identifier<string> GRAPHS_FUNCTIONS;
+extern Identifier<string> GRAPHS_BLOCKS;
+extern Identifier<int> GRAPHS_TOP;
+extern Identifier<string> TIME_CACHE;
+extern Identifier<bool> SHARED_TIMES;
+
 class ExeGraph: public ParExeGraph {
 public:
 	ExeGraph(
@@ -22,7 +47,6 @@ public:
 		// initialization
 		info = otawa::patmos::INFO(ws->process());
 		ASSERT(info);
-		reg_count = ws->process()->platform()->regCount();
 
 		// lookout for stage
 		for(ParExePipeline::StageIterator stage(proc->pipeline()); stage; stage++) {
@@ -45,11 +69,12 @@ public:
 	virtual void addEdgesForProgramOrder(genstruct::SLList<ParExeStage *> *list_of_stages) {
 		
 		// prepare the stages
+		elm::genstruct::SLList<ParExeStage *> stages;
 		elm::genstruct::SLList<ParExeStage *> *list;
 		if(list_of_stages)
 			list = list_of_stages;
 		else {
-			list = new  elm::genstruct::SLList<ParExeStage *>;
+			list = &stages;
 			for(ParExePipeline::StageIterator stage(_microprocessor->pipeline()) ; stage ; stage++)
 				if(stage->orderPolicy() == ParExeStage::IN_ORDER) {
 					if(stage->category() != ParExeStage::FETCH
@@ -63,50 +88,59 @@ public:
 			addBundledProgramOrder(stage);
 	}
 
+	/**
+	 * Build the data dependencies in one forward pass: the last writer
+	 * of each register (its MEM node for a load, none else as the result
+	 * is forwarded) is recorded and linked to the EX node of the readers.
+	 */
 	virtual void findDataDependencies(void) {
-#	if 0
-		// prepare registers bank
-		ParExeNode *regs[reg_count];
-		//elm::array::set(regs, reg_count, static_cast<ParExeNode *>(0));
-		for(int i = 0; i < reg_count; i++)
-			regs[i] = 0;
-
-		// look in the instructions
+		ParExeNode *writers[otawa::patmos::REG_MASK_SIZE];
+		for(int i = 0; i < otawa::patmos::REG_MASK_SIZE; i++)
+			writers[i] = 0;
+
 		for (InstIterator inst(this->getSequence()) ; inst ; inst++)  {
 
-			// process read registers
-			const elm::genstruct::Table<hard::Register *>& reads = inst->inst()->readRegs();
-			ParExeNode *exe_node = 0;
-			for(int i = 0; i < reads.count(); i++)
-				if(regs[reads[i]->platformNumber()]) {
-					if(!exe_node) {
-						for(ParExeInst::NodeIterator node(inst); node; node++)
-							if(node->stage() == exe_stage) {
-								exe_node = node;
-								break;
-							}
-						ASSERT(exe_node);
-					}
-					ASSERT(0 <= reads[i]->platformNumber() && reads[i]->platformNumber() < reg_count);
-					new ParExeEdge(regs[reads[i]->platformNumber()], exe_node, ParExeEdge::SOLID);
-				}
+			// look for the EX and MEM nodes (an instruction not using
+			// the ALU gets its operands in its last stage)
+			ParExeNode *exe_node = 0, *mem_node = 0, *last_node = 0;
+			for(ParExeInst::NodeIterator node(inst); node; node++) {
+				if(node->stage() == exe_stage)
+					exe_node = node;
+				else if(node->stage() == mem_stage)
+					mem_node = node;
+				last_node = node;
+			}
+			if(!exe_node)
+				exe_node = last_node;
 
-			// process written registers if load only
-			const elm::genstruct::Table<hard::Register *>& writs = inst->inst()->writtenRegs();
-			ParExeNode *mem_node = 0;
-			for(int i = 0; i < writs.count(); i++) {
-				if(inst->inst()->isLoad() && !mem_node) {
-					for(ParExeInst::NodeIterator node(inst); node; node++)
-						if(node->stage() == mem_stage) {
-								mem_node = node;
-								break;
-							}
-					ASSERT(mem_node);
+			// process read registers (a writer is linked once whatever
+			// the number of registers it provides to the instruction)
+			otawa::patmos::reg_mask_t reads = exe_node ? info->readMask(inst->inst()) : 0;
+			ParExeNode *linked[otawa::patmos::REG_MASK_SIZE];
+			int linked_cnt = 0;
+			while(reads) {
+				int i = __builtin_ctzll(reads);
+				reads &= reads - 1;
+				if(!writers[i])
+					continue;
+				int j = 0;
+				while(j < linked_cnt && linked[j] != writers[i])
+					j++;
+				if(j == linked_cnt) {
+					new ParExeEdge(writers[i], exe_node, ParExeEdge::SOLID);
+					linked[linked_cnt++] = writers[i];
 				}
-				regs[writs[i]->platformNumber()] = mem_node;
+			}
+
+			// process written registers (delayed only for loads)
+			otawa::patmos::reg_mask_t writes = info->writeMask(inst->inst());
+			ParExeNode *writer = inst->inst()->isLoad() ? mem_node : 0;
+			while(writes) {
+				int i = __builtin_ctzll(writes);
+				writes &= writes - 1;
+				writers[i] = writer;
 			}
 		}
-#		endif
 	}
 
 private:
@@ -134,23 +168,636 @@ private:
 	}
 
 	otawa::patmos::Info *info;
-	int reg_count;
 	ParExeStage *exe_stage, *mem_stage;
 };
 
+/**
+ * Arena of the instructions of the sequences of execution graphs.
+ * The memory is kept from one computation to the next: reset() only
+ * destroys the instructions and the slabs are then reused.
+ */
+class SequenceArena {
+public:
+	static const int SLAB_SIZE = 16 * 1024;
+
+	SequenceArena(void): slab(0), cur(0), top(0) { }
+
+	~SequenceArena(void) {
+		reset();
+		for(int i = 0; i < slabs.count(); i++)
+			delete [] slabs[i];
+	}
+
+	/**
+	 * Build an instruction of a sequence in the arena.
+	 * @param inst		Instruction.
+	 * @param bb		Block of the instruction.
+	 * @param part		Code part (prologue, body).
+	 * @param index		Index in the sequence.
+	 * @return			Built instruction.
+	 */
+	ParExeInst *make(Inst *inst, BasicBlock *bb, code_part_t part, int index) {
+		ParExeInst *r = new(allocate(sizeof(ParExeInst))) ParExeInst(inst, bb, part, index);
+		insts.add(r);
+		return r;
+	}
+
+	/**
+	 * Destroy the instructions of the arena and make its memory available again.
+	 */
+	void reset(void) {
+		for(int i = 0; i < insts.count(); i++)
+			insts[i]->~ParExeInst();
+		insts.clear();
+		slab = 0;
+		cur = top = 0;
+	}
+
+private:
+
+	void *allocate(size_t size) {
+		size = (size + 7) & ~size_t(7);
+		if(cur + size > top) {
+			ASSERT(size <= size_t(SLAB_SIZE));
+			if(slab == slabs.count())
+				slabs.add(new char[SLAB_SIZE]);
+			cur = slabs[slab++];
+			top = cur + SLAB_SIZE;
+		}
+		void *r = cur;
+		cur += size;
+		return r;
+	}
+
+	genstruct::Vector<char *> slabs;
+	genstruct::Vector<ParExeInst *> insts;
+	int slab;
+	char *cur, *top;
+};
+
+
+/**
+ * Memoization table of the execution times of block sequences.
+ * The key is a signature of the instructions of the prologue and
+ * of the body: as the time only depends on these instructions, the same
+ * sequences found in different contexts are only computed once.
+ */
+class TimeMemo {
+public:
+	typedef genstruct::Vector<t::uint32> key_t;
+
+	TimeMemo(void): buckets(0), bcnt(0), cnt(0), _hits(0), _misses(0) { }
+	~TimeMemo(void) { clear(); }
+
+	/**
+	 * Look for a signature in the table.
+	 * @param key	Signature to look for.
+	 * @param time	Found time.
+	 * @return		True if the signature is found, false else.
+	 */
+	bool find(const key_t& key, ot::time& time) {
+		if(get(key, time)) {
+			_hits++;
+			return true;
+		}
+		_misses++;
+		return false;
+	}
+
+	/**
+	 * Test if a signature is in the table, without counting
+	 * it in the statistics.
+	 * @param key	Signature to look for.
+	 * @return		True if the signature is found, false else.
+	 */
+	bool contains(const key_t& key) {
+		ot::time time;
+		return get(key, time);
+	}
+
+	/**
+	 * Record the time of a signature.
+	 * @param key	Signature.
+	 * @param time	Time of the signature.
+	 */
+	void add(const key_t& key, ot::time time) {
+		if(cnt >= bcnt * 2)
+			grow();
+		node_t *node = new node_t;
+		node->hash = hash(key);
+		node->time = time;
+		node->size = key.count();
+		node->words = new t::uint32[key.count()];
+		for(int i = 0; i < key.count(); i++)
+			node->words[i] = key[i];
+		node->next = buckets[node->hash & (bcnt - 1)];
+		buckets[node->hash & (bcnt - 1)] = node;
+		cnt++;
+	}
+
+	/**
+	 * Remove all entries and reset the statistics.
+	 */
+	void clear(void) {
+		for(int i = 0; i < bcnt; i++)
+			for(node_t *node = buckets[i], *next; node; node = next) {
+				next = node->next;
+				delete [] node->words;
+				delete node;
+			}
+		delete [] buckets;
+		buckets = 0;
+		bcnt = 0;
+		cnt = 0;
+		_hits = 0;
+		_misses = 0;
+	}
+
+	inline int count(void) const { return cnt; }
+	inline t::uint64 hits(void) const { return _hits; }
+	inline t::uint64 misses(void) const { return _misses; }
+
+private:
+	typedef struct node_t {
+		struct node_t *next;
+		t::uint32 hash;
+		int size;
+		t::uint32 *words;
+		ot::time time;
+	} node_t;
+
+	static t::uint32 hash(const key_t& key) {
+		t::uint32 h = 2166136261U;
+		for(int i = 0; i < key.count(); i++)
+			h = (h ^ key[i]) * 16777619U;
+		return h;
+	}
+
+	static bool equals(node_t *node, const key_t& key) {
+		if(node->size != key.count())
+			return false;
+		for(int i = 0; i < node->size; i++)
+			if(node->words[i] != key[i])
+				return false;
+		return true;
+	}
+
+	bool get(const key_t& key, ot::time& time) {
+		if(!bcnt)
+			return false;
+		t::uint32 h = hash(key);
+		for(node_t *node = buckets[h & (bcnt - 1)]; node; node = node->next)
+			if(node->hash == h && equals(node, key)) {
+				time = node->time;
+				return true;
+			}
+		return false;
+	}
+
+	void grow(void) {
+		int nbcnt = bcnt ? bcnt * 2 : 256;
+		node_t **nbuckets = new node_t *[nbcnt];
+		for(int i = 0; i < nbcnt; i++)
+			nbuckets[i] = 0;
+		for(int i = 0; i < bcnt; i++)
+			for(node_t *node = buckets[i], *next; node; node = next) {
+				next = node->next;
+				node->next = nbuckets[node->hash & (nbcnt - 1)];
+				nbuckets[node->hash & (nbcnt - 1)] = node;
+			}
+		delete [] buckets;
+		buckets = nbuckets;
+		bcnt = nbcnt;
+	}
+
+	node_t **buckets;
+	int bcnt, cnt;
+	t::uint64 _hits, _misses;
+};
+
+
+/**
+ * Memoized times shared by the analyses of a process (batch mode, daemon),
+ * one table by configuration fingerprint. The tables are released with the
+ * process, when its property is deleted.
+ */
+class SharedMemos: public Lock {
+public:
+	~SharedMemos(void) {
+		for(int i = 0; i < memos.count(); i++)
+			delete memos[i].snd;
+	}
+
+	/**
+	 * Get the table of a configuration, creating it if needed.
+	 * @param fingerprint	Configuration fingerprint.
+	 * @return				Table of memoized times.
+	 */
+	TimeMemo *get(t::uint64 fingerprint) {
+		for(int i = 0; i < memos.count(); i++)
+			if(memos[i].fst == fingerprint)
+				return memos[i].snd;
+		TimeMemo *memo = new TimeMemo();
+		memos.add(pair(fingerprint, memo));
+		return memo;
+	}
+
+private:
+	genstruct::Vector<Pair<t::uint64, TimeMemo *> > memos;
+};
+
+static Identifier<AutoPtr<SharedMemos> > SHARED_MEMO("tcrest::patmos_wcet::SHARED_MEMO", AutoPtr<SharedMemos>());
+
+
+/**
+ * Pair of 64-bit hashes (FNV-1a and a multiplicative one) used
+ * as content key of the persistent time cache.
+ */
+class Hasher {
+public:
+	Hasher(t::uint64 seed = 0): h1(14695981039346656037ULL ^ seed), h2(seed) { }
+
+	inline void add(t::uint32 w) {
+		for(int i = 0; i < 4; i++, w >>= 8)
+			h1 = (h1 ^ (w & 0xff)) * 1099511628211ULL;
+		h2 = (h2 + w + 1) * 0x9E3779B97F4A7C15ULL;
+		h2 ^= h2 >> 29;
+	}
+
+	inline void addString(const string& s) {
+		for(int i = 0; i < s.length(); i++)
+			add(t::uint32(s[i]));
+		add(t::uint32(s.length()));
+	}
+
+	t::uint64 h1, h2;
+};
+
+
+/**
+ * Persistent cache of the sequence times, shared by the analyses of
+ * successive builds of a program. The file starts with a header and is
+ * followed by fixed-size records only appended (an atomic write per record)
+ * so that concurrent analyses may share it. At opening, the file is mapped
+ * and its records are loaded in a memory table.
+ *
+ * The file is never visible without its header: it is created under
+ * a temporary name and then linked (new file) or renamed (file
+ * of another timing model version) to its actual name.
+ */
+class TimeCache {
+public:
+	static const t::uint32 MAGIC = 0x50544331;		// "PTC1"
+
+	typedef struct header_t {
+		t::uint32 magic;
+		t::uint32 version;	// timing model version
+		t::uint32 size;		// record size
+		t::uint32 pad;
+	} header_t;
+
+	typedef struct record_t {
+		t::uint64 key1, key2;
+		t::int64 time;
+	} record_t;
+
+	TimeCache(void): fd(-1), _loaded(0), _stored(0) { }
+	~TimeCache(void) { close(); }
+
+	inline bool isOpen(void) const { return fd >= 0; }
+	inline int loaded(void) const { return _loaded; }
+	inline int stored(void) const { return _stored; }
+
+	/**
+	 * Open the cache file, creating it if needed, and load its records.
+	 * A file of another timing model version is replaced.
+	 * @param path		Path of the file.
+	 * @param version	Timing model version.
+	 * @return			True for success, false else.
+	 */
+	bool open(const string& path, t::uint32 version) {
+		for(int attempt = 0; attempt < 3; attempt++) {
+
+			// open or create the file
+			fd = ::open(path.toCString().chars(), O_RDWR | O_APPEND);
+			if(fd < 0) {
+				if(errno != ENOENT || !create(path, version, false))
+					return false;
+				continue;
+			}
+			struct stat st;
+			if(fstat(fd, &st) < 0) {
+				close();
+				return false;
+			}
+
+			// check the header
+			void *p = 0;
+			bool ok = size_t(st.st_size) >= sizeof(header_t);
+			if(ok) {
+				p = mmap(0, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+				if(p == MAP_FAILED) {
+					close();
+					return false;
+				}
+				const header_t *h = static_cast<const header_t *>(p);
+				ok = h->magic == MAGIC && h->version == version && h->size == sizeof(record_t);
+			}
+			if(!ok) {
+				if(p)
+					munmap(p, st.st_size);
+				close();
+				if(!create(path, version, true))
+					return false;
+				continue;
+			}
+
+			// load the records
+			const record_t *recs = reinterpret_cast<const record_t *>(static_cast<const header_t *>(p) + 1);
+			int n = (st.st_size - sizeof(header_t)) / sizeof(record_t);
+			for(int i = 0; i < n; i++) {
+				TimeMemo::key_t key;
+				makeKey(recs[i].key1, recs[i].key2, key);
+				table.add(key, recs[i].time);
+			}
+			_loaded = n;
+			munmap(p, st.st_size);
+			return true;
+		}
+		return false;
+	}
+
+	/**
+	 * Look for a time in the cache.
+	 * @param hash	Content key.
+	 * @param time	Found time.
+	 * @return		True if found, false else.
+	 */
+	bool find(const Hasher& hash, ot::time& time) {
+		TimeMemo::key_t key;
+		makeKey(hash.h1, hash.h2, key);
+		return table.find(key, time);
+	}
+
+	/**
+	 * Add a time to the cache and to the file.
+	 * @param hash	Content key.
+	 * @param time	Time to store.
+	 */
+	void add(const Hasher& hash, ot::time time) {
+		TimeMemo::key_t key;
+		makeKey(hash.h1, hash.h2, key);
+		table.add(key, time);
+		record_t r;
+		r.key1 = hash.h1;
+		r.key2 = hash.h2;
+		r.time = time;
+		if(::write(fd, &r, sizeof(r)) == sizeof(r))
+			_stored++;
+	}
+
+	/**
+	 * Close the cache file.
+	 */
+	void close(void) {
+		if(fd >= 0)
+			::close(fd);
+		fd = -1;
+		table.clear();
+	}
+
+private:
+
+	/**
+	 * Create an empty cache file, made of the header only.
+	 * @param path		Path of the file.
+	 * @param version	Timing model version.
+	 * @param replace	True to replace the existing file, false to let
+	 * 					a file created meanwhile by another analysis.
+	 * @return			True for success, false else.
+	 */
+	static bool create(const string& path, t::uint32 version, bool replace) {
+		StringBuffer buf;
+		buf << path << "." << getpid() << ".tmp";
+		string tmp = buf.toString();
+		int tfd = ::open(tmp.toCString().chars(), O_WRONLY | O_CREAT | O_EXCL, 0666);
+		if(tfd < 0)
+			return false;
+		header_t h;
+		h.magic = MAGIC;
+		h.version = version;
+		h.size = sizeof(record_t);
+		h.pad = 0;
+		bool ok = ::write(tfd, &h, sizeof(h)) == sizeof(h);
+		::close(tfd);
+		if(ok) {
+			if(replace)
+				ok = rename(tmp.toCString().chars(), path.toCString().chars()) == 0;
+			else
+				ok = link(tmp.toCString().chars(), path.toCString().chars()) == 0 || errno == EEXIST;
+		}
+		unlink(tmp.toCString().chars());
+		return ok;
+	}
+
+	static void makeKey(t::uint64 k1, t::uint64 k2, TimeMemo::key_t& key) {
+		key.add(t::uint32(k1));
+		key.add(t::uint32(k1 >> 32));
+		key.add(t::uint32(k2));
+		key.add(t::uint32(k2 >> 32));
+	}
+
+	int fd;
+	TimeMemo table;
+	int _loaded, _stored;
+};
+
+
 class BBTimer: public GraphBBTime<ExeGraph> {
 public:
 	static p::declare reg;
-	BBTimer(void): GraphBBTime<ExeGraph>(reg) { }
+
+	// version of the timing model, to increase for any change of the
+	// computed times (it invalidates the persistent cache)
+	static const t::uint32 MODEL_VERSION = 2;
+
+	BBTimer(void): GraphBBTime<ExeGraph>(reg), info(0), memo(0), shared(false), threads(1), window(-1), check(false), mismatches(0), top_count(0), fingerprint(0), cursors(0), limits(0), aborted(false), failed(0) { }
+
+	virtual void configure(const PropList& props) {
+		GraphBBTime<ExeGraph>::configure(props);
+		threads = THREADS(props);
+		if(threads < 1)
+			threads = 1;
+		window = PROLOGUE_WINDOW(props);
+		check = CHECK_PROLOGUE_WINDOW(props);
+		shared = SHARED_TIMES(props);
+
+		// graph dump configuration
+		archive = GRAPHS_ARCHIVE(props);
+		cache_path = TIME_CACHE(props);
+		top_count = GRAPHS_TOP(props);
+		functions.clear();
+		blocks.clear();
+		string funs = GRAPHS_FUNCTIONS(props);
+		for(int p = 0; p < funs.length(); ) {
+			int q = funs.indexOf(',', p);
+			if(q < 0)
+				q = funs.length();
+			if(q > p)
+				functions.add(funs.substring(p, q - p));
+			p = q + 1;
+		}
+		string bbs = GRAPHS_BLOCKS(props);
+		const char *p = bbs.toCString().chars();
+		while(*p) {
+			char *e;
+			selection_t sel;
+			sel.source = -1;
+			sel.target = strtol(p, &e, 10);
+			if(e == p)
+				throw ProcessorException(*this, _ << "bad block selection: " << bbs);
+			if(*e == '-') {
+				sel.source = sel.target;
+				p = e + 1;
+				sel.target = strtol(p, &e, 10);
+				if(e == p)
+					throw ProcessorException(*this, _ << "bad block selection: " << bbs);
+			}
+			blocks.add(sel);
+			p = *e == ',' ? e + 1 : e;
+		}
+	}
 
 protected:
 
+	virtual void setup(WorkSpace *ws) {
+		GraphBBTime<ExeGraph>::setup(ws);
+		info = otawa::patmos::INFO(ws->process());
+		ASSERT(info);
+		if(!shared) {
+			memo = &own;
+			memo->clear();
+		}
+		else
+			memo = 0;	// selected by the configuration fingerprint
+		mismatches = 0;
+		dumps.clear();
+		tops.clear();
+		fingerprint = 0;
+	}
+
+	virtual void cleanup(WorkSpace *ws) {
+		if(memo && logFor(Processor::LOG_BLOCK))
+			log << "\tmemoized times: " << memo->count() << " sequences, "
+				<< memo->hits() << " hits, " << memo->misses() << " misses" << io::endl;
+		if(check && logFor(Processor::LOG_BLOCK))
+			log << "\tprologue window mismatches: " << mismatches << io::endl;
+		dumpGraphs();
+		if(cache.isOpen()) {
+			if(logFor(Processor::LOG_CFG))
+				log << "\ttime cache: " << cache.loaded() << " loaded, "
+					<< cache.stored() << " stored" << io::endl;
+			cache.close();
+		}
+		if(!shared)
+			memo->clear();
+		memo = 0;
+		for(int i = 0; i < procs.count(); i++)
+			delete procs[i];
+		procs.clear();
+		GraphBBTime<ExeGraph>::cleanup(ws);
+	}
+
+	virtual void processCFG(WorkSpace *ws, CFG *cfg) {
+
+		// the default window is the pipeline depth
+		if(window < 0) {
+			window = 0;
+			for(ParExePipeline::StageIterator stage(_microprocessor->pipeline()); stage; stage++)
+				window++;
+			if(logFor(Processor::LOG_CFG))
+				log << "\tprologue window: " << window << " bundles" << io::endl;
+		}
+
+		// the configuration fingerprint keys the shared and the persistent times
+		if(!fingerprint) {
+			fingerprint = configFingerprint(ws);
+			if(shared) {
+				AutoPtr<SharedMemos> memos = SHARED_MEMO(ws->process());
+				if(memos.isNull()) {
+					memos = new SharedMemos();
+					SHARED_MEMO(ws->process()) = memos;
+				}
+				memo = memos->get(fingerprint);
+			}
+			if(!cache_path.isEmpty() && !cache.open(cache_path, MODEL_VERSION))
+				log << "\tWARNING: cannot use time cache " << cache_path << io::endl;
+		}
+
+		if(threads <= 1)
+			GraphBBTime<ExeGraph>::processCFG(ws, cfg);
+		else
+			processParallel(ws, cfg);
+	}
+
 	virtual void processBB(WorkSpace *ws, CFG *cfg, BasicBlock *bb) {
 		if(bb->isEnd())
 			return;
 		
 		// computation of each edge
 		genstruct::Vector<Edge *> edges;
+		collectEdges(cfg, bb, edges);
+		
+		// compute the times
+		genstruct::Vector<ot::time> times;
+		for(int i = 0; i < edges.count(); i++)
+			times.add(compute(ws, cfg, edges[i], bb));
+		record(cfg, bb, edges, times);
+	}
+
+	virtual ot::time compute(WorkSpace *ws, CFG *cfg, Edge *edge, BasicBlock *bb)  {
+		if(logFor(Processor::LOG_BLOCK))
+			log << "\t\t\t" << edge << io::endl;
+
+		// look in the memoized times (not when checking the window
+		// as sequences sharing the windowed signature must be compared)
+		TimeMemo::key_t key;
+		signature(edge->source(), bb, key);
+		ot::time cost;
+		if(!check && lookup(edge->source(), bb, key, cost)) {
+			if(logFor(Processor::LOG_BLOCK))
+				log << "\t\t\t\tmemo hit: " << cost << " (" << memo->hits() << " hits, "
+					<< memo->misses() << " misses)" << io::endl;
+			return cost;
+		}
+
+		// compute the sequence
+		cost = computeSequence(edge->source(), bb, true, arena);
+		if(check)
+			checkWindow(edge->source(), bb, cost);
+		store(edge->source(), bb, key, cost);
+		return cost;
+	}
+
+private:
+
+	/**
+	 * Timing job of the parallel mode.
+	 */
+	typedef struct job_t {
+		Edge *edge;
+		BasicBlock *bb;
+		int owner;		// index of the job computing the same sequence, -1 if none
+		ot::time time;
+	} job_t;
+
+	/**
+	 * Collect the edges to time for a block.
+	 * @param cfg	Current CFG.
+	 * @param bb	Current block.
+	 * @param edges	Collected edges.
+	 */
+	void collectEdges(CFG *cfg, BasicBlock *bb, genstruct::Vector<Edge *>& edges) {
 		for(BasicBlock::InIterator edge(bb); edge; edge++) {
 			if(!edge->source()->isEntry() || !cfg->hasProp(CALLED_BY))
 				edges.add(edge);
@@ -158,15 +805,24 @@ protected:
 				for(Identifier<Edge *>::Getter edge(cfg, CALLED_BY); edge; edge++)
 					edges.add(edge);
 		}
-		
+	}
+
+	/**
+	 * Record the time of a block and the deltas of its edges.
+	 * @param cfg	Current CFG.
+	 * @param bb	Current block.
+	 * @param edges	Timed edges.
+	 * @param times	Times of the edges.
+	 */
+	void record(CFG *cfg, BasicBlock *bb, const genstruct::Vector<Edge *>& edges, const genstruct::Vector<ot::time>& times) {
+		if(!archive.isEmpty())
+			for(int i = 0; i < edges.count(); i++)
+				select(cfg, edges[i]->source(), bb, times[i]);
+
 		// compute the minimum
-		genstruct::Vector<ot::time> times;
 		ot::time btime = type_info<ot::time>::max;
-		for(int i = 0; i < edges.count(); i++) {
-			ot::time time = compute(ws, cfg, edges[i], bb);
-			times.add(time);
-			btime = min(btime, time);
-		}
+		for(int i = 0; i < times.count(); i++)
+			btime = min(btime, times[i]);
 		
 		// build the delta
 		ipet::TIME(bb) = btime;
@@ -179,45 +835,635 @@ protected:
 		}
 	}
 
-	virtual ot::time compute(WorkSpace *ws, CFG *cfg, Edge *edge, BasicBlock *bb)  {
-		if(logFor(Processor::LOG_BLOCK))
-			log << "\t\t\t" << edge << io::endl;
+	/**
+	 * Build and analyze the execution graph of a sequence.
+	 * @param source	Prologue block.
+	 * @param target	Body block.
+	 * @param output	True to output the graph.
+	 * @param arena		Arena to allocate the sequence in (reset at exit).
+	 * @param full		True to use the whole source block as prologue.
+	 * @param dump		If not null, output to dump the graph to.
+	 * @param proc		Microprocessor to build the graph on (null for the one of the timer).
+	 * @return			Time of the sequence.
+	 */
+	ot::time computeSequence(BasicBlock *source, BasicBlock *target, bool output, SequenceArena& arena, bool full = false, io::Output *dump = 0, ParExeProc *proc = 0) {
+		ot::time cost;
+		{
+			// initialize the sequence
+			int index = 0;
+			ParExeSequence seq;
+
+			// fill with previous block instructions
+			genstruct::Vector<Inst *> insts;
+			prologue(source, full ? 0 : window, insts);
+			for(int i = 0; i < insts.count(); i++)
+				seq.addLast(arena.make(insts[i], source, PROLOGUE, index++));
 
-		// compute source and target
-		BasicBlock 	*source = edge->source(),
-					*target = bb;
+			// fill with current block instructions
+			for(BasicBlock::InstIterator inst(target); inst; inst++)
+				seq.addLast(arena.make(inst, target, BODY, index++));
 
-		// initialize the sequence
-		int index = 0;
-		ParExeSequence *seq = new ParExeSequence();
+			// build the graph
+			PropList props;
+			ExeGraph graph(this->workspace(), proc ? proc : _microprocessor, &seq, props);
+			graph.build();
 
-		// fill with previous block instructions
-		if(!source->isEnd())
-			for(BasicBlock::InstIterator inst(source); inst; inst++) {
-				ParExeInst * par_exe_inst = new ParExeInst(inst, source, PROLOGUE, index++);
-				seq->addLast(par_exe_inst);
+			// compute the graph
+			cost = graph.analyze();
+			if(output)
+				outputGraph(&graph, source->number(), target->number(), 0, "");
+			if(dump) {
+				*dump << "// " << source << " -> " << target << ": " << cost << io::endl;
+				graph.dump(*dump);
 			}
+		}
+		arena.reset();
+		return cost;
+	}
+
+	/**
+	 * Time the blocks of a CFG with a pool of threads.
+	 *
+	 * The jobs, one by (edge, block), are prepared in the main thread:
+	 * memoized and duplicated sequences are resolved and the lazy
+	 * decoding of the instructions is forced (see prepare()).
+	 * Only the remaining sequences are timed by the threads. Each thread
+	 * owns a range of jobs and steals from the ranges of the other threads
+	 * once its own range is done. The times are recorded in the main thread,
+	 * in block order, after the threads are joined. Graphs are not output
+	 * in this mode.
+	 *
+	 * While the threads run, the main thread only runs the first worker
+	 * and the threads only read shared state:
+	 *	- the CFG, the instructions of its blocks and their kind and size,
+	 *	- the register tables and masks of the instructions, built by prepare(),
+	 *	- the bundle maps of the process (built at load time),
+	 *	- the properties of the workspace and of the process (no property
+	 *	  is written until the threads are joined).
+	 * The decode cache, the instruction arena, the lazy decoding of the
+	 * instructions and the memory of the process (Process::get()) are never
+	 * reached from the graphs once the blocks are prepared. The mutable
+	 * state of the graph computation is private to each thread: the sequence
+	 * arena and the microprocessor, whose stages record the nodes of the
+	 * graph being built.
+	 *
+	 * @param ws	Current workspace.
+	 * @param cfg	Current CFG.
+	 */
+	void processParallel(WorkSpace *ws, CFG *cfg) {
 
-		// fill with current block instructions
-		for(BasicBlock::InstIterator inst(target); inst; inst++) {
-			ParExeInst * par_exe_inst = new ParExeInst(inst, target, BODY, index++);
-			seq->addLast(par_exe_inst);
+		// build the jobs
+		TimeMemo pending;	// sequence signature -> index of the job computing it
+		genstruct::Vector<int> bbs;
+		jobs.clear();
+		todo.clear();
+		for(CFG::BBIterator bb(cfg); bb; bb++) {
+			if(bb->isEnd())
+				continue;
+			genstruct::Vector<Edge *> edges;
+			collectEdges(cfg, bb, edges);
+			bbs.add(jobs.count());
+			prepare(bb);
+			for(int i = 0; i < edges.count(); i++) {
+				job_t job;
+				job.edge = edges[i];
+				job.bb = bb;
+				job.owner = -1;
+				job.time = 0;
+				prepare(edges[i]->source());
+				TimeMemo::key_t key;
+				signature(edges[i]->source(), bb, key);
+				ot::time t;
+				if(check) {
+					job.owner = jobs.count();
+					todo.add(jobs.count());
+				}
+				else if(lookup(edges[i]->source(), bb, key, t))
+					job.time = t;
+				else if(pending.find(key, t))
+					job.owner = int(t);
+				else {
+					pending.add(key, jobs.count());
+					job.owner = jobs.count();
+					todo.add(jobs.count());
+				}
+				jobs.add(job);
+			}
 		}
+		bbs.add(jobs.count());
+		if(logFor(Processor::LOG_CFG))
+			log << "\t\t" << todo.count() << " sequences to time over " << jobs.count()
+				<< " edges with " << threads << " threads" << io::endl;
 
-		// build the graph
-		PropList props;
-		ExeGraph graph(this->workspace(), _microprocessor, seq, props);
-		graph.build();
-		
-		// compute the graph
-		ot::time cost = graph.analyze();
-		outputGraph(&graph, source->number(), target->number(), 0, "");
-		return cost;
+		// run the threads
+		runJobs();
+
+		// record the results
+		for(int i = 0; i < todo.count(); i++) {
+			job_t& job = jobs[todo[i]];
+			TimeMemo::key_t key;
+			signature(job.edge->source(), job.bb, key);
+			store(job.edge->source(), job.bb, key, job.time);
+			if(check)
+				checkWindow(job.edge->source(), job.bb, job.time);
+		}
+		for(int b = 0; b + 1 < bbs.count(); b++) {
+			genstruct::Vector<Edge *> edges;
+			genstruct::Vector<ot::time> times;
+			for(int i = bbs[b]; i < bbs[b + 1]; i++) {
+				edges.add(jobs[i].edge);
+				times.add(jobs[i].owner >= 0 ? jobs[jobs[i].owner].time : jobs[i].time);
+			}
+			if(logFor(Processor::LOG_BLOCK))
+				log << "\t\t\t" << jobs[bbs[b]].bb << io::endl;
+			record(cfg, jobs[bbs[b]].bb, edges, times);
+		}
+	}
+
+	/**
+	 * Force the lazy decoding of the instructions of a block, as it
+	 * is not thread-safe: iterating on the block decodes its instructions,
+	 * building the register tables decodes the register masks (in the
+	 * decode cache) and allocates in the instruction arena, and the bundle
+	 * size and start are checked to come from a bundle map, not from
+	 * the memory of the process.
+	 * @param bb	Block to prepare.
+	 */
+	void prepare(BasicBlock *bb) {
+		if(bb->isEnd())
+			return;
+		for(BasicBlock::InstIterator inst(bb); inst; inst++) {
+			inst->readRegs();
+			inst->writtenRegs();
+			if(!info->hasBundleMap(inst->address()))
+				throw ProcessorException(*this, _ << "no bundle map for instruction at " << inst->address());
+			info->bundleSize(inst->address());
+		}
+	}
+
+	/**
+	 * Run the pending jobs on the thread pool.
+	 */
+	void runJobs(void) {
+		int n = min(threads, todo.count());
+		if(!n)
+			return;
+		cursors = new int[n];
+		limits = new int[n];
+		for(int i = 0; i < n; i++) {
+			cursors[i] = todo.count() * i / n;
+			limits[i] = todo.count() * (i + 1) / n;
+		}
+
+		// one microprocessor by thread (the first worker runs in the main thread)
+		while(procs.count() < n - 1)
+			procs.add(new ParExeProc(workspace()->platform()->processor()));
+
+		// start the threads
+		aborted = false;
+		failed = 0;
+		error = "";
+		worker_t *workers = new worker_t[n];
+		pthread_t *ids = new pthread_t[n];
+		int started = 1;
+		for(int i = 0; i < n; i++) {
+			workers[i].timer = this;
+			workers[i].id = i;
+			workers[i].cnt = n;
+			workers[i].proc = i ? procs[i - 1] : 0;
+		}
+		for(; started < n; started++)
+			if(pthread_create(&ids[started], 0, run, &workers[started])) {
+				aborted = true;
+				break;
+			}
+
+		// work and wait for the threads
+		if(!aborted)
+			run(&workers[0]);
+		for(int i = 1; i < started; i++)
+			pthread_join(ids[i], 0);
+		delete [] workers;
+		delete [] ids;
+		delete [] cursors;
+		delete [] limits;
+		cursors = 0;
+		limits = 0;
+		if(failed)
+			throw ProcessorException(*this, _ << "sequence timing failed: " << error);
+		if(aborted)
+			throw ProcessorException(*this, "cannot create timing thread");
+	}
+
+	typedef struct worker_t {
+		BBTimer *timer;
+		int id, cnt;
+		SequenceArena arena;
+		ParExeProc *proc;
+	} worker_t;
+
+	static void *run(void *arg) {
+		worker_t *worker = static_cast<worker_t *>(arg);
+		worker->timer->work(worker->id, worker->cnt, worker->arena, worker->proc);
+		return 0;
+	}
+
+	/**
+	 * Work of a thread: consume its own range then steal
+	 * in the ranges of the other threads. An exception must not escape
+	 * the thread: the first one is kept and all the threads are stopped.
+	 * @param id	Thread identifier.
+	 * @param cnt	Number of threads.
+	 * @param arena	Sequence arena of the thread.
+	 * @param proc	Microprocessor of the thread (null for the one of the timer).
+	 */
+	void work(int id, int cnt, SequenceArena& arena, ParExeProc *proc) {
+		try {
+			for(int k = 0; k < cnt && !aborted; k++) {
+				int r = (id + k) % cnt;
+				while(!aborted) {
+					int i = __sync_fetch_and_add(&cursors[r], 1);
+					if(i >= limits[r])
+						break;
+					job_t& job = jobs[todo[i]];
+					job.time = computeSequence(job.edge->source(), job.bb, false, arena, false, 0, proc);
+				}
+			}
+		}
+		catch(elm::Exception& e) {
+			if(__sync_bool_compare_and_swap(&failed, 0, 1))
+				error = e.message();
+			aborted = true;
+		}
+	}
+
+	/**
+	 * Get the instructions of the prologue, that is, the instructions
+	 * of the last bundles of the source block.
+	 * @param source	Prologue block.
+	 * @param bundles	Maximum number of bundles (0 for the whole block).
+	 * @param insts		Prologue instructions.
+	 */
+	void prologue(BasicBlock *source, int bundles, genstruct::Vector<Inst *>& insts) {
+		if(source->isEnd())
+			return;
+		genstruct::Vector<Inst *> all;
+		for(BasicBlock::InstIterator inst(source); inst; inst++)
+			all.add(inst);
+
+		// find the start of the window
+		int start = all.count();
+		if(!bundles)
+			start = 0;
+		while(start > 0 && bundles) {
+			start--;
+			if(info->isBundleStart(all[start]->address()))
+				bundles--;
+		}
+		for(int i = start; i < all.count(); i++)
+			insts.add(all[i]);
+	}
+
+	/**
+	 * Compare the time of a sequence with a windowed prologue with the
+	 * time of the same sequence with the whole prologue and log the mismatches.
+	 * @param source	Prologue block.
+	 * @param target	Body block.
+	 * @param time		Time with the windowed prologue.
+	 */
+	void checkWindow(BasicBlock *source, BasicBlock *target, ot::time time) {
+		ot::time full = computeSequence(source, target, false, arena, true);
+		if(full != time) {
+			mismatches++;
+			if(logFor(Processor::LOG_BLOCK))
+				log << "\t\t\t\tWARNING: prologue window mismatch for " << source << " -> " << target
+					<< ": " << time << " (window) != " << full << " (full)" << io::endl;
+		}
+	}
+
+	/**
+	 * Look for the time of a sequence in the memoized times then
+	 * in the persistent cache.
+	 * @param source	Prologue block.
+	 * @param target	Body block.
+	 * @param key		Signature of the sequence.
+	 * @param time		Found time.
+	 * @return			True if the time is found, false else.
+	 */
+	bool lookup(BasicBlock *source, BasicBlock *target, const TimeMemo::key_t& key, ot::time& time) {
+		if(memo->find(key, time))
+			return true;
+		if(!cache.isOpen() || !cache.find(contentHash(source, target), time))
+			return false;
+		memo->add(key, time);
+		return true;
+	}
+
+	/**
+	 * Record a computed time in the memoized times and in the persistent cache.
+	 * @param source	Prologue block.
+	 * @param target	Body block.
+	 * @param key		Signature of the sequence.
+	 * @param time		Computed time.
+	 */
+	void store(BasicBlock *source, BasicBlock *target, const TimeMemo::key_t& key, ot::time time) {
+		if(check && memo->contains(key))
+			return;		// already recorded, the window is being checked
+		memo->add(key, time);
+		if(cache.isOpen())
+			cache.add(contentHash(source, target), time);
+	}
+
+	/**
+	 * Compute the content hash of a sequence: the words of its instructions
+	 * and their bundle start flags, seeded with the configuration fingerprint.
+	 * As addresses are not hashed, a moved but unchanged block keeps its time.
+	 * @param source	Prologue block.
+	 * @param target	Body block.
+	 * @return			Content hash.
+	 */
+	Hasher contentHash(BasicBlock *source, BasicBlock *target) {
+		Hasher hash(fingerprint);
+		genstruct::Vector<Inst *> insts;
+		prologue(source, window, insts);
+		hash.add(insts.count());
+		for(BasicBlock::InstIterator inst(target); inst; inst++)
+			insts.add(inst);
+		for(int i = 0; i < insts.count(); i++) {
+			Address a = insts[i]->address();
+			hash.add((insts[i]->size() << 1) | (info->isBundleStart(a) ? 1 : 0));
+			for(ot::size j = 0; j < insts[i]->size(); j += 4) {
+				t::uint32 w;
+				workspace()->process()->get(a + j, w);
+				hash.add(w);
+			}
+		}
+		return hash;
+	}
+
+	/**
+	 * Compute the fingerprint of the timing configuration: timing model
+	 * version, pipeline stages and the stages of their functional units
+	 * (a non-pipelined unit is a single stage with the whole latency),
+	 * caches, memory banks and prologue window.
+	 * @param ws	Current workspace.
+	 * @return		Configuration fingerprint (never null).
+	 */
+	t::uint64 configFingerprint(WorkSpace *ws) {
+		Hasher hash;
+		hash.add(MODEL_VERSION);
+		hash.add(window);
+		for(ParExePipeline::StageIterator stage(_microprocessor->pipeline()); stage; stage++) {
+			hashStage(hash, stage);
+			for(int i = 0; i < stage->numFus(); i++) {
+				int cnt = 0;
+				for(ParExePipeline::StageIterator fu(stage->fu(i)); fu; fu++, cnt++)
+					hashStage(hash, fu);
+				hash.add(cnt);
+			}
+		}
+		const hard::CacheConfiguration& caches = ws->platform()->cache();
+		hashCache(hash, caches.instCache());
+		hashCache(hash, caches.dataCache());
+		const hard::Memory& mem = ws->platform()->memory();
+		for(int i = 0; i < mem.banks().count(); i++) {
+			const hard::Bank *bank = mem.banks()[i];
+			hash.add(bank->address().offset());
+			hash.add(bank->size());
+			hash.add(bank->latency());
+			hash.add(bank->writeLatency());
+		}
+		return hash.h1 ? hash.h1 : 1;
+	}
+
+	static void hashStage(Hasher& hash, ParExeStage *stage) {
+		hash.addString(stage->name());
+		hash.add(stage->latency());
+		hash.add(stage->width());
+		hash.add(stage->category());
+		hash.add(stage->orderPolicy());
+		hash.add(stage->numFus());
+	}
+
+	static void hashCache(Hasher& hash, const hard::Cache *cache) {
+		if(!cache) {
+			hash.add(0);
+			return;
+		}
+		hash.add(cache->blockBits());
+		hash.add(cache->rowBits());
+		hash.add(cache->wayBits());
+		hash.add(cache->replacementPolicy());
+		hash.add(cache->missPenalty());
+	}
+
+	/**
+	 * Select a sequence to dump if it matches the filters.
+	 * @param cfg		Current CFG.
+	 * @param source	Prologue block.
+	 * @param target	Body block.
+	 * @param time		Time of the sequence.
+	 */
+	void select(CFG *cfg, BasicBlock *source, BasicBlock *target, ot::time time) {
+		dump_t d;
+		d.source = source;
+		d.target = target;
+		d.time = time;
+
+		// selected by function or block
+		bool sel = false;
+		for(int i = 0; !sel && i < functions.count(); i++)
+			sel = cfg->label() == functions[i];
+		for(int i = 0; !sel && i < blocks.count(); i++)
+			sel = blocks[i].target == target->number()
+				&& (blocks[i].source < 0 || blocks[i].source == source->number());
+		if(sel)
+			dumps.add(d);
+
+		// selected by time (tops sorted by decreasing time)
+		if(top_count > 0 && (tops.count() < top_count || tops[tops.count() - 1].time < time)) {
+			if(tops.count() == top_count)
+				tops.removeAt(tops.count() - 1);
+			int i = tops.count();
+			while(i > 0 && tops[i - 1].time < time)
+				i--;
+			tops.insert(i, d);
+		}
+	}
+
+	/**
+	 * Dump the selected graphs in the archive file. The graphs are
+	 * computed again and streamed one after the other in the archive,
+	 * a sequence selected several times (by the filters and by time)
+	 * being dumped once.
+	 */
+	void dumpGraphs(void) {
+		if(archive.isEmpty() || (dumps.isEmpty() && tops.isEmpty()))
+			return;
+		genstruct::Vector<dump_t> all;
+		for(int i = 0; i < dumps.count(); i++)
+			if(!contains(all, dumps[i]))
+				all.add(dumps[i]);
+		for(int i = 0; i < tops.count(); i++)
+			if(!contains(all, tops[i]))
+				all.add(tops[i]);
+		FILE *file = fopen(archive.toCString().chars(), "w");
+		if(!file) {
+			log << "\tWARNING: cannot open graph archive " << archive << io::endl;
+			return;
+		}
+		ArchiveStream stream(file);
+		io::Output out(stream);
+		for(int i = 0; i < all.count(); i++)
+			computeSequence(all[i].source, all[i].target, false, arena, false, &out);
+		out.flush();
+		if(logFor(Processor::LOG_CFG))
+			log << "\t" << all.count() << " graphs dumped to " << archive << io::endl;
+	}
+
+	static bool contains(const genstruct::Vector<dump_t>& ds, const dump_t& d) {
+		for(int i = 0; i < ds.count(); i++)
+			if(ds[i].source == d.source && ds[i].target == d.target)
+				return true;
+		return false;
+	}
+
+	/**
+	 * Build the signature of the sequence made of the given blocks:
+	 * the instruction count of the prologue followed, for each instruction,
+	 * by its address and its size combined with its bundle start flag.
+	 * As only the window of the prologue is signed, sequences sharing
+	 * the same window share the same time.
+	 * @param source	Prologue block.
+	 * @param target	Body block.
+	 * @param key		Built signature.
+	 */
+	void signature(BasicBlock *source, BasicBlock *target, TimeMemo::key_t& key) {
+		genstruct::Vector<Inst *> insts;
+		prologue(source, window, insts);
+		key.add(insts.count());
+		for(int i = 0; i < insts.count(); i++)
+			sign(insts[i], key);
+		for(BasicBlock::InstIterator inst(target); inst; inst++)
+			sign(inst, key);
 	}
+
+	inline void sign(Inst *inst, TimeMemo::key_t& key) {
+		key.add(inst->address().offset());
+		key.add((inst->size() << 1) | (info->isBundleStart(inst->address()) ? 1 : 0));
+	}
+
+	otawa::patmos::Info *info;
+	TimeMemo own, *memo;
+	bool shared;
+	SequenceArena arena;
+	int threads;
+	int window;
+	bool check;
+	int mismatches;
+
+	// graph dump
+	typedef struct selection_t {
+		int source, target;		// source is -1 for any source
+	} selection_t;
+	typedef struct dump_t {
+		BasicBlock *source, *target;
+		ot::time time;
+	} dump_t;
+	string archive;
+	genstruct::Vector<string> functions;
+	genstruct::Vector<selection_t> blocks;
+	int top_count;
+	genstruct::Vector<dump_t> dumps, tops;
+
+	// persistent cache
+	string cache_path;
+	t::uint64 fingerprint;
+	TimeCache cache;
+
+	genstruct::Vector<job_t> jobs;
+	genstruct::Vector<int> todo;
+	int *cursors, *limits;
+	genstruct::Vector<ParExeProc *> procs;
+	volatile bool aborted;
+	volatile int failed;
+	string error;
 };
 
 p::declare BBTimer::reg = p::init("tcrest::patmos_wcet::BBTimer", Version(1, 0, 0))
 	.base(GraphBBTime<ParExeGraph>::reg)
 	.maker<BBTimer>();
 
+
+/**
+ * Number of threads used by the BBTimer to compute the block times
+ * (default to 1, sequential computation). The graph dumps (GRAPHS_ARCHIVE
+ * and its selections) are supported whatever the number of threads:
+ * the sequences are selected when their time is recorded and their graphs
+ * are built again, sequentially, at the end of the analysis.
+ */
+Identifier<int> THREADS("tcrest::patmos_wcet::THREADS", 1);
+
+
+/**
+ * Number of bundles of the predecessor block used as prologue of the
+ * execution graphs: 0 for the whole block, a negative value (default)
+ * for the number of stages of the pipeline.
+ */
+Identifier<int> PROLOGUE_WINDOW("tcrest::patmos_wcet::PROLOGUE_WINDOW", -1);
+
+
+/**
+ * If set to true, each time computed with a windowed prologue is
+ * compared with the time obtained with the whole prologue and
+ * mismatches are logged at the block level (default to false). In this mode,
+ * the times are computed for every edge, without using the memoized times.
+ */
+Identifier<bool> CHECK_PROLOGUE_WINDOW("tcrest::patmos_wcet::CHECK_PROLOGUE_WINDOW", false);
+
+
+/**
+ * Path of the file the selected execution graphs are dumped to
+ * (default to none, no dump).
+ */
+Identifier<string> GRAPHS_ARCHIVE("tcrest::patmos_wcet::GRAPHS_ARCHIVE", "");
+
+
+/**
+ * Comma-separated list of the functions whose execution graphs are dumped.
+ */
+Identifier<string> GRAPHS_FUNCTIONS("tcrest::patmos_wcet::GRAPHS_FUNCTIONS", "");
+
+
+/**
+ * Comma-separated list of the blocks, given by their number, whose execution
+ * graphs are dumped. An item "S-T" selects only the edge from block S
+ * to block T.
+ */
+Identifier<string> GRAPHS_BLOCKS("tcrest::patmos_wcet::GRAPHS_BLOCKS", "");
+
+
+/**
+ * Number of the most expensive execution graphs to dump (default to 0).
+ */
+Identifier<int> GRAPHS_TOP("tcrest::patmos_wcet::GRAPHS_TOP", 0);
+
+
+/**
+ * Path of the persistent cache file of the sequence times (default to none).
+ * The times are keyed by the content of the sequences and the pipeline and
+ * memory configuration: the unchanged code of a new build of a program is not
+ * analyzed again.
+ */
+Identifier<string> TIME_CACHE("tcrest::patmos_wcet::TIME_CACHE", "");
+
+
+/**
+ * Keep the memoized sequence times on the process, instead of the BBTimer,
+ * to share them between the analyses of several tasks of the same
+ * program (default to false). The times are kept by configuration fingerprint
+ * and released with the process. It is set by the batch mode and the daemon.
+ */
+Identifier<bool> SHARED_TIMES("tcrest::patmos_wcet::SHARED_TIMES", false);
+
 } }		// tcrest::patmos
@@ -0,0 +1,199 @@
+/*
+ * License HERE!
+ */
+
+#include <otawa/proc/Processor.h>
+#include <otawa/prog/WorkSpace.h>
+#include <otawa/cfg/features.h>
+#include <otawa/ipet/features.h>
+#include <otawa/script/Script.h>
+#include "ArchiveStream.h"
+#include <elm/string/StringBuffer.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/time.h>
+
+namespace tcrest { namespace patmos {
+
+using namespace otawa;
+
+extern Identifier<string> TASKS;
+extern Identifier<string> TASK_FILE;
+extern Identifier<string> BATCH_SCRIPT;
+extern Identifier<string> BATCH_OUTPUT;
+extern Identifier<sys::Path> PML_OUTPUT;
+extern Identifier<bool> SHARED_TIMES;
+
+/**
+ * Batch analysis of several tasks of the same program.
+ *
+ * Each task is analyzed by the script @ref BATCH_SCRIPT in its own workspace,
+ * but all workspaces share the process of the current one: the program is loaded
+ * and decoded once and the loader caches (decoded instructions, bundles, symbols)
+ * as well as the memoized sequence times of the BBTimer are shared by the tasks.
+ *
+ * One record is written by task to @ref BATCH_OUTPUT, as a tab-separated line:
+ * task entry, WCET (-1 if the analysis failed), analysis time in milliseconds
+ * and, in case of failure, the error message. The PML results of a task are
+ * written to "<program>.<task>.wcet.pml".
+ *
+ * @p Configuration
+ * @li @ref TASKS
+ * @li @ref TASK_FILE
+ * @li @ref BATCH_SCRIPT
+ * @li @ref BATCH_OUTPUT
+ */
+class BatchAnalysis: public Processor {
+public:
+	static p::declare reg;
+	BatchAnalysis(p::declare& r = reg): Processor(r) { }
+
+protected:
+
+	virtual void configure(const PropList& props) {
+		Processor::configure(props);
+		conf.clearProps();
+		conf.addProps(props);
+		script = BATCH_SCRIPT(props);
+		output = BATCH_OUTPUT(props);
+
+		// task list
+		tasks.clear();
+		split(TASKS(props));
+		string path = TASK_FILE(props);
+		if(!path.isEmpty()) {
+			FILE *file = fopen(path.toCString().chars(), "r");
+			if(!file)
+				throw ProcessorException(*this, _ << "cannot open task file " << path);
+			char *line = 0;
+			size_t cap = 0;
+			while(getline(&line, &cap, file) >= 0) {
+				char *c = strchr(line, '#');
+				if(c)
+					*c = '\0';
+				split(line);
+			}
+			free(line);
+			fclose(file);
+		}
+		if(tasks.isEmpty())
+			throw ProcessorException(*this, "no task to analyze");
+	}
+
+	virtual void processWorkSpace(WorkSpace *ws) {
+
+		// open the output
+		sys::Path p = output;
+		if(p.toString().isEmpty())
+			p = sys::Path(ws->process()->program()->name()).setExtension("batch");
+		FILE *file = fopen(p.toString().toCString().chars(), "w");
+		if(!file)
+			throw ProcessorException(*this, _ << "cannot create batch output " << p);
+		ArchiveStream stream(file);
+		io::Output out(stream);
+
+		// analyze the tasks
+		int failed = 0;
+		for(int i = 0; i < tasks.count(); i++) {
+			if(logFor(LOG_DEPS))
+				log << "\ttask " << tasks[i] << io::endl;
+			PropList props;
+			props.addProps(conf);
+			TASK_ENTRY(props) = tasks[i].toCString();
+			script::PATH(props) = sys::Path(script);
+			SHARED_TIMES(props) = true;
+			StringBuffer ext;
+			ext << tasks[i] << ".wcet.pml";
+			PML_OUTPUT(props) = sys::Path(ws->process()->program()->name()).setExtension(ext.toString());
+
+			WorkSpace *tws = new WorkSpace(ws->process());
+			t::uint64 start = now();
+			try {
+				script::Script scr;
+				scr.process(tws, props);
+				out << tasks[i] << '\t' << ipet::WCET(tws) << '\t' << ((now() - start) / 1000) << io::endl;
+			}
+			catch(elm::Exception& e) {
+				failed++;
+				out << tasks[i] << "\t-1\t" << ((now() - start) / 1000) << '\t' << e.message() << io::endl;
+			}
+			out.flush();
+			delete tws;
+		}
+
+		if(logFor(LOG_DEPS))
+			log << "\t" << tasks.count() << " tasks analyzed (" << failed << " failed), results in " << p << io::endl;
+	}
+
+private:
+
+	/**
+	 * Add the tasks of a list separated by commas or blanks. A task already
+	 * in the list is not added again (it would overwrite its own results).
+	 * @param list	List of tasks.
+	 */
+	void split(const string& list) {
+		for(int p = 0; p < list.length(); ) {
+			int q = p;
+			while(q < list.length() && list[q] != ',' && list[q] != ' ' && list[q] != '\t' && list[q] != '\n' && list[q] != '\r')
+				q++;
+			if(q > p) {
+				string task = list.substring(p, q - p);
+				if(!tasks.contains(task))
+					tasks.add(task);
+			}
+			p = q + 1;
+		}
+	}
+
+	static t::uint64 now(void) {
+		struct timeval tv;
+		gettimeofday(&tv, 0);
+		return t::uint64(tv.tv_sec) * 1000000 + tv.tv_usec;
+	}
+
+	PropList conf;
+	string script, output;
+	genstruct::Vector<string> tasks;
+};
+
+
+/**
+ * Feature ensuring that all the tasks of the batch have been analyzed.
+ */
+p::feature BATCH_FEATURE("tcrest::patmos::BATCH_FEATURE", new Maker<BatchAnalysis>());
+
+p::declare BatchAnalysis::reg = p::init("tcrest::patmos::BatchAnalysis", Version(1, 0, 0))
+	.base(Processor::reg)
+	.maker<BatchAnalysis>()
+	.provide(BATCH_FEATURE);
+
+
+/**
+ * Entry symbols of the tasks to analyze in batch mode, separated by commas
+ * or blanks (default to none).
+ */
+Identifier<string> TASKS("tcrest::patmos::TASKS", "");
+
+
+/**
+ * Path of a file giving the entry symbols of the tasks to analyze in batch mode,
+ * one or several by line, "#" starting a comment (default to none).
+ */
+Identifier<string> TASK_FILE("tcrest::patmos::TASK_FILE", "");
+
+
+/**
+ * Script used to analyze each task in batch mode (default to "patmos_wcet.osx").
+ */
+Identifier<string> BATCH_SCRIPT("tcrest::patmos::BATCH_SCRIPT", "patmos_wcet.osx");
+
+
+/**
+ * Path of the file the batch results are written to (default to the path
+ * of the program with the extension ".batch").
+ */
+Identifier<string> BATCH_OUTPUT("tcrest::patmos::BATCH_OUTPUT", "");
+
+} }	// tcrest::patmos
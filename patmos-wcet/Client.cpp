@@ -0,0 +1,143 @@
+/*
+ * License HERE!
+ */
+
+#include "Daemon.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+/**
+ * Look for the checksum of an ELF file in a flow fact file
+ * (line "checksum "<file>" <sum>;").
+ * @param ff	Flow fact file.
+ * @param elf	ELF file.
+ * @param sum	Found checksum.
+ * @return		True if the checksum is found.
+ */
+static bool findChecksum(const char *ff, const char *elf, long& sum) {
+	FILE *f = fopen(ff, "r");
+	if(!f)
+		return false;
+	const char *base = strrchr(elf, '/');
+	base = base ? base + 1 : elf;
+	char line[1024], name[1024];
+	bool found = false;
+	while(!found && fgets(line, sizeof(line), f)) {
+		char *p = line;
+		while(*p == ' ' || *p == '\t')
+			p++;
+		if(sscanf(p, "checksum \"%1023[^\"]\" %li", name, &sum) == 2) {
+			const char *n = strrchr(name, '/');
+			found = strcmp(n ? n + 1 : name, base) == 0;
+		}
+	}
+	fclose(f);
+	return found;
+}
+
+static void usage(const char *cmd) {
+	fprintf(stderr, "usage: %s [-s socket] [-e entry] [-f flowfacts] [-c checksum] [-x script] [-p id=value]... elf\n", cmd);
+}
+
+int main(int argc, char **argv) {
+	const char *path = PATMOS_WCETD_SOCKET, *entry = 0, *ff = 0, *sum = 0, *script = 0;
+	char elf[PATH_MAX], facts[PATH_MAX];
+	FILE *req = tmpfile();
+	if(!req) {
+		perror("tmpfile");
+		return 1;
+	}
+
+	// parse arguments
+	int opt;
+	while((opt = getopt(argc, argv, "s:e:f:c:x:p:h")) != -1)
+		switch(opt) {
+		case 's': path = optarg; break;
+		case 'e': entry = optarg; break;
+		case 'f': ff = optarg; break;
+		case 'c': sum = optarg; break;
+		case 'x': script = optarg; break;
+		case 'p': fprintf(req, "config %s\n", optarg); break;
+		default:
+			usage(argv[0]);
+			return opt == 'h' ? 0 : 1;
+		}
+	if(optind != argc - 1) {
+		usage(argv[0]);
+		return 1;
+	}
+
+	// paths are sent absolute as the daemon has its own working directory
+	if(!realpath(argv[optind], elf)) {
+		perror(argv[optind]);
+		return 1;
+	}
+	if(ff && !realpath(ff, facts)) {
+		perror(ff);
+		return 1;
+	}
+
+	// build the request
+	fprintf(req, "elf %s\n", elf);
+	if(entry)
+		fprintf(req, "entry %s\n", entry);
+	if(script)
+		fprintf(req, "script %s\n", script);
+	if(ff)
+		fprintf(req, "flowfacts %s\n", facts);
+	long s;
+	if(sum)
+		fprintf(req, "checksum %s\n", sum);
+	else if(ff && findChecksum(facts, elf, s))
+		fprintf(req, "checksum 0x%08lx\n", s);
+	fprintf(req, "\n");
+
+	// connect to the daemon
+	struct sockaddr_un addr;
+	if(strlen(path) >= sizeof(addr.sun_path)) {
+		fprintf(stderr, "ERROR: socket path too long: %s\n", path);
+		return 1;
+	}
+	int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+	if(fd < 0) {
+		perror("socket");
+		return 1;
+	}
+	memset(&addr, 0, sizeof(addr));
+	addr.sun_family = AF_UNIX;
+	strcpy(addr.sun_path, path);
+	if(connect(fd, (struct sockaddr *)&addr, sizeof(addr)) < 0) {
+		perror(path);
+		return 1;
+	}
+
+	// send the request
+	char buf[4096];
+	size_t n;
+	rewind(req);
+	while((n = fread(buf, 1, sizeof(buf), req)) > 0)
+		if(write(fd, buf, n) != ssize_t(n)) {
+			perror("write");
+			return 1;
+		}
+	fclose(req);
+	shutdown(fd, SHUT_WR);
+
+	// display the reply
+	FILE *in = fdopen(fd, "r");
+	bool ok = false;
+	while(fgets(buf, sizeof(buf), in)) {
+		if(strcmp(buf, "\n") == 0)
+			break;
+		if(strcmp(buf, "status ok\n") == 0)
+			ok = true;
+		fputs(buf, stdout);
+	}
+	fclose(in);
+	return ok ? 0 : 1;
+}
@@ -0,0 +1,202 @@
+/*
+ * License HERE!
+ */
+#ifndef TCREST_PATMOS_CONTEXTS_H
+#define TCREST_PATMOS_CONTEXTS_H
+
+#include <otawa/cfg/features.h>
+#include <otawa/ipet/features.h>
+#include "../otawa-patmos/patmos.h"
+
+namespace tcrest { namespace patmos {
+
+using namespace otawa;
+
+/**
+ * Function instances of the task, that is, the functions in their calling
+ * context, as far as the CFGs give it.
+ *
+ * Without virtualization, each CFG is an instance shared by all the CALL
+ * edges reaching it. With virtualized CFGs, each inlined copy of a function,
+ * made of the blocks between a VIRTUAL_CALL edge and the VIRTUAL_RETURN edges,
+ * is an instance of its own reached by a single call; the functions not
+ * inlined (recursive ones) remain whole CFGs called by CALL edges.
+ *
+ * The instance 0 is the task entry. The functions are numbered by address,
+ * whatever the number of their instances. The size of a function is the size
+ * of its ELF symbol, if any, as it covers the whole function (unreachable code,
+ * padding, embedded data), else the size of its reachable blocks.
+ */
+class Contexts {
+public:
+
+	typedef struct call_t {
+		Edge *edge;		// CALL or VIRTUAL_CALL edge
+		int inst;		// callee instance (in calls) or caller instance (in callers)
+	} call_t;
+
+	typedef struct instance_t {
+		CFG *cfg;			// CFG containing the blocks
+		Edge *call;			// VIRTUAL_CALL edge of an inlined copy, null for a whole CFG
+		int fun;			// function number
+		string name;		// function label, and call block for an inlined copy
+		genstruct::Vector<BasicBlock *> bbs;
+		genstruct::Vector<call_t> calls;
+		genstruct::Vector<call_t> callers;
+	} instance_t;
+
+	Contexts(const CFGCollection *coll, otawa::patmos::Info *info = 0) {
+		for(int i = 0; i < coll->count(); i++) {
+			wholes.add(-1);
+			owners.add(new genstruct::Vector<int>());
+			for(int j = 0; j < coll->get(i)->countBB(); j++)
+				owners[i]->add(-1);
+		}
+		for(int i = 0; i < coll->count(); i++)
+			whole(coll->get(i));
+		if(info)
+			for(int f = 0; f < funs.count(); f++) {
+				ot::size size = info->functionSize(funs[f]);
+				if(size)
+					sizes[f] = size;
+			}
+	}
+
+	~Contexts(void) {
+		for(int i = 0; i < insts.count(); i++)
+			delete insts[i];
+		for(int i = 0; i < owners.count(); i++)
+			delete owners[i];
+	}
+
+	inline int count(void) const { return insts.count(); }
+	inline const instance_t& operator[](int i) const { return *insts[i]; }
+	inline int countFunctions(void) const { return funs.count(); }
+	inline Address functionAddress(int f) const { return funs[f]; }
+	inline ot::size functionSize(int f) const { return sizes[f]; }
+
+	/**
+	 * Get the instance owning a block.
+	 * @param cfg	CFG of the block.
+	 * @param bb	Looked block.
+	 * @return		Instance number or -1 (unreachable block).
+	 */
+	inline int owner(CFG *cfg, BasicBlock *bb) const { return (*owners[cfg->number()])[bb->number()]; }
+
+	/**
+	 * Get the variable counting the entries in an instance, that is,
+	 * the executions of its CFG entry or of its call.
+	 * @param i		Instance number.
+	 * @return		Entry count variable.
+	 */
+	inline ilp::Var *entries(int i) const
+		{ return insts[i]->call ? calls(insts[i]->call) : ipet::VAR(insts[i]->cfg->entry()); }
+
+	/**
+	 * Get the variable counting the executions of a call. A CALL edge has no
+	 * variable of its own and is performed each time its block is executed.
+	 * @param call	CALL or VIRTUAL_CALL edge.
+	 * @return		Call count variable.
+	 */
+	static inline ilp::Var *calls(Edge *call)
+		{ return call->kind() == Edge::CALL ? ipet::VAR(call->source()) : ipet::VAR(call); }
+
+private:
+
+	/**
+	 * Get the instance of a whole CFG, building it if needed.
+	 */
+	int whole(CFG *cfg) {
+		if(wholes[cfg->number()] < 0) {
+			wholes[cfg->number()] = insts.count();	// recursive calls
+			make(cfg, cfg->entry(), 0, cfg->address(), cfg->label());
+		}
+		return wholes[cfg->number()];
+	}
+
+	/**
+	 * Build an instance by traversing its blocks from its first block.
+	 * The inlined calls are skipped (built as their own instances) and the
+	 * traversal continues at their return block.
+	 * @param cfg		Containing CFG.
+	 * @param first		First block.
+	 * @param call		VIRTUAL_CALL edge for an inlined copy, null else.
+	 * @param addr		Function address.
+	 * @param name		Instance name.
+	 * @return			Instance number.
+	 */
+	int make(CFG *cfg, BasicBlock *first, Edge *call, Address addr, const string& name) {
+		int i = insts.count();
+		instance_t *inst = new instance_t;
+		inst->cfg = cfg;
+		inst->call = call;
+		inst->fun = function(addr);
+		inst->name = name;
+		insts.add(inst);
+		genstruct::Vector<int>& own = *owners[cfg->number()];
+		ot::size size = 0;
+
+		genstruct::Vector<BasicBlock *> todo;
+		todo.push(first);
+		while(!todo.isEmpty()) {
+			BasicBlock *bb = todo.pop();
+			if(own[bb->number()] >= 0)
+				continue;
+			own[bb->number()] = i;
+			if(bb->isExit())
+				continue;
+			if(!bb->isEntry()) {
+				inst->bbs.add(bb);
+				size += bb->size();
+			}
+			for(BasicBlock::OutIterator edge(bb); edge; edge++)
+				switch(edge->kind()) {
+				case Edge::CALL:
+					if(edge->calledCFG())
+						link(i, edge, whole(edge->calledCFG()));
+					break;
+				case Edge::VIRTUAL_CALL: {
+						CFG *called = CALLED_CFG(edge);
+						link(i, edge, make(cfg, edge->target(), edge,
+							called ? called->address() : edge->target()->address(),
+							_ << (called ? called->label() : string("fun")) << "_" << bb->number()));
+						if(VIRTUAL_RETURN_BLOCK(bb))
+							todo.push(VIRTUAL_RETURN_BLOCK(bb));
+					}
+					break;
+				case Edge::VIRTUAL_RETURN:
+					break;
+				default:
+					todo.push(edge->target());
+					break;
+				}
+		}
+		sizes[inst->fun] = max(sizes[inst->fun], size);
+		return i;
+	}
+
+	void link(int caller, Edge *edge, int callee) {
+		call_t call = { edge, callee }, back = { edge, caller };
+		insts[caller]->calls.add(call);
+		insts[callee]->callers.add(back);
+	}
+
+	int function(Address addr) {
+		for(int i = 0; i < funs.count(); i++)
+			if(funs[i] == addr)
+				return i;
+		funs.add(addr);
+		sizes.add(0);
+		return funs.count() - 1;
+	}
+
+	genstruct::Vector<instance_t *> insts;
+	genstruct::Vector<int> wholes;
+	genstruct::Vector<genstruct::Vector<int> *> owners;
+	genstruct::Vector<Address> funs;
+	genstruct::Vector<ot::size> sizes;
+};
+
+} }	// tcrest::patmos
+
+#endif	// TCREST_PATMOS_CONTEXTS_H
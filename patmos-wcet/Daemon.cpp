@@ -0,0 +1,408 @@
+/*
+ * License HERE!
+ */
+
+#include <otawa/prog/Manager.h>
+#include <otawa/prog/WorkSpace.h>
+#include <otawa/prog/Segment.h>
+#include <otawa/proc/ProcessorPlugin.h>
+#include <otawa/cfg/features.h>
+#include <otawa/ipet/features.h>
+#include <otawa/script/Script.h>
+#include <otawa/util/FlowFactLoader.h>
+#include <otawa/util/Fletcher.h>
+#include <elm/string/StringBuffer.h>
+#include "Daemon.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <sys/un.h>
+
+namespace tcrest { namespace patmos {
+
+using namespace otawa;
+
+/**
+ * Analysis daemon keeping the loaded programs resident.
+ *
+ * The programs are identified by the Fletcher checksum of their ELF file:
+ * a request giving the checksum of an already loaded program is analyzed
+ * without reading the file. Each request is analyzed in its own workspace
+ * sharing the process of the program, so that the loader caches and
+ * the memoized times of the BBTimer (kept by configuration fingerprint) are
+ * kept from one request to the other. The flow facts installed on the
+ * instructions are removed before each request.
+ * The plugins loaded by the scripts remain loaded as well. At most
+ * a fixed number of programs are kept, the least recently used being
+ * released first.
+ *
+ * The connections are served one after the other, and so the requests are
+ * serialized: a client waits until the connections accepted before it are
+ * closed. To prevent an idle client from blocking the others, a connection
+ * that sends nothing for the configured timeout is closed.
+ */
+class Daemon {
+public:
+	typedef struct {
+		string elf, entry, flowfacts, script;
+		bool has_sum;
+		t::uint32 sum;
+		genstruct::Vector<string> configs;
+	} request_t;
+
+	Daemon(int max_programs): max(max_programs), clock(0) { }
+
+	~Daemon(void) {
+		for(int i = 0; i < progs.count(); i++)
+			delete progs[i].ws;
+	}
+
+	/**
+	 * Serve the requests of a connection. The connection is closed at end
+	 * of stream or if the client is idle for more than the given timeout.
+	 * @param fd		Connection socket.
+	 * @param timeout	Idle timeout in seconds (0 for none).
+	 */
+	void serve(int fd, int timeout) {
+		if(timeout > 0) {
+			struct timeval tv;
+			tv.tv_sec = timeout;
+			tv.tv_usec = 0;
+			if(setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv)) < 0
+			|| setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv)) < 0)
+				perror("setsockopt");
+		}
+		FILE *in = fdopen(fd, "r"), *out = fdopen(dup(fd), "w");
+		if(!in || !out) {
+			if(in)
+				fclose(in);
+			else
+				close(fd);
+			if(out)
+				fclose(out);
+			return;
+		}
+		request_t r;
+		while(receive(in, r)) {
+			handle(r, out);
+			fflush(out);
+		}
+		if(ferror(in) && (errno == EAGAIN || errno == EWOULDBLOCK))
+			fprintf(stderr, "WARNING: idle connection closed\n");
+		fclose(in);
+		fclose(out);
+	}
+
+private:
+	typedef struct {
+		t::uint32 sum;
+		WorkSpace *ws;
+		t::uint64 used;
+	} program_t;
+
+	/**
+	 * Read a request.
+	 * @param in	Input stream.
+	 * @param r		Read request.
+	 * @return		True if a request has been read, false at end of stream
+	 *				or on error (including the idle timeout).
+	 */
+	bool receive(FILE *in, request_t& r) {
+		r.elf = "";
+		r.entry = "main";
+		r.flowfacts = "";
+		r.script = "patmos_wcet.osx";
+		r.has_sum = false;
+		r.sum = 0;
+		r.configs.clear();
+		bool any = false;
+		char line[4096];
+		while(fgets(line, sizeof(line), in)) {
+			int n = strlen(line);
+			while(n > 0 && (line[n - 1] == '\n' || line[n - 1] == '\r'))
+				line[--n] = '\0';
+			if(!n) {
+				if(any)
+					return true;
+				continue;
+			}
+			any = true;
+			char *v = strchr(line, ' ');
+			if(!v)
+				continue;
+			*v++ = '\0';
+			if(strcmp(line, "elf") == 0)
+				r.elf = v;
+			else if(strcmp(line, "checksum") == 0) {
+				r.has_sum = true;
+				r.sum = strtoul(v, 0, 0);
+			}
+			else if(strcmp(line, "entry") == 0)
+				r.entry = v;
+			else if(strcmp(line, "flowfacts") == 0)
+				r.flowfacts = v;
+			else if(strcmp(line, "script") == 0)
+				r.script = v;
+			else if(strcmp(line, "config") == 0)
+				r.configs.add(v);
+		}
+		if(ferror(in))
+			return false;
+		return any;
+	}
+
+	/**
+	 * Analyze a request and send the reply.
+	 * @param r		Request.
+	 * @param out	Output stream.
+	 */
+	void handle(const request_t& r, FILE *out) {
+		t::uint64 start = now();
+		WorkSpace *tws = 0;
+		bool loaded = false;
+		try {
+			WorkSpace *ws = program(r, loaded);
+			clearFlowFacts(ws->process());
+
+			// configuration
+			PropList props;
+			TASK_ENTRY(props) = r.entry.toCString();
+			script::PATH(props) = sys::Path(r.script);
+			if(!r.flowfacts.isEmpty()) {
+				if(r.flowfacts.endsWith(".pml"))
+					set(props, "otawa::patmos::PML_PATH", r.flowfacts, true);
+				else
+					FLOW_FACTS_PATH(props) = sys::Path(r.flowfacts);
+			}
+			set(props, "tcrest::patmos_wcet::SHARED_TIMES", "true", false);
+			for(int i = 0; i < r.configs.count(); i++) {
+				int e = r.configs[i].indexOf('=');
+				if(e < 0)
+					throw otawa::Exception(_ << "bad configuration " << r.configs[i]);
+				set(props, r.configs[i].substring(0, e), r.configs[i].substring(e + 1), true);
+			}
+
+			// analysis
+			tws = new WorkSpace(ws->process());
+			script::Script scr;
+			scr.process(tws, props);
+			ot::time wcet = ipet::WCET(tws);
+			delete tws;
+			tws = 0;
+			fprintf(out, "status ok\nwcet %lld\nloaded %s\ntime %llu\n\n", (long long)wcet,
+				loaded ? "yes" : "no", (unsigned long long)((now() - start) / 1000));
+		}
+		catch(elm::Exception& e) {
+			if(tws)
+				delete tws;
+			fprintf(out, "status error\nloaded %s\ntime %llu\nmessage %s\n\n", loaded ? "yes" : "no",
+				(unsigned long long)((now() - start) / 1000), e.message().toCString().chars());
+		}
+	}
+
+	/**
+	 * Find the workspace of the program of a request, loading it if needed.
+	 * @param r			Request.
+	 * @param loaded	Set to true if the program has been loaded.
+	 * @return			Workspace of the program.
+	 */
+	WorkSpace *program(const request_t& r, bool& loaded) {
+		if(r.elf.isEmpty())
+			throw otawa::Exception("no ELF file");
+
+		// already loaded?
+		if(r.has_sum) {
+			WorkSpace *ws = lookup(r.sum);
+			if(ws)
+				return ws;
+		}
+		t::uint32 sum = checksum(r.elf);
+		if(r.has_sum && sum != r.sum)
+			throw otawa::Exception(_ << "checksum mismatch for " << r.elf);
+		if(!r.has_sum) {
+			WorkSpace *ws = lookup(sum);
+			if(ws)
+				return ws;
+		}
+
+		// release the least recently used program
+		if(progs.count() >= max) {
+			int lru = 0;
+			for(int i = 1; i < progs.count(); i++)
+				if(progs[i].used < progs[lru].used)
+					lru = i;
+			delete progs[lru].ws;
+			progs.removeAt(lru);
+		}
+
+		// load it
+		program_t p;
+		p.sum = sum;
+		p.ws = MANAGER.load(sys::Path(r.elf));
+		p.used = ++clock;
+		progs.add(p);
+		loaded = true;
+		return p.ws;
+	}
+
+	WorkSpace *lookup(t::uint32 sum) {
+		for(int i = 0; i < progs.count(); i++)
+			if(progs[i].sum == sum) {
+				progs[i].used = ++clock;
+				return progs[i].ws;
+			}
+		return 0;
+	}
+
+	/**
+	 * Remove the flow facts left on the instructions by the previous
+	 * requests (flow fact and PML loaders), so that each request
+	 * only uses its own flow facts.
+	 * @param proc	Process of the program.
+	 */
+	static void clearFlowFacts(Process *proc) {
+		static const AbstractIdentifier *ids[] = {
+			&MAX_ITERATION, &MIN_ITERATION, &TOTAL_ITERATION, &CONTEXTUAL_LOOP_BOUND,
+			&IGNORE_CONTROL, &IGNORE_SEQ, &IGNORE_ENTRY, &BRANCH_TARGET, &CALL_TARGET,
+			&NO_CALL, &NO_RETURN
+		};
+		for(Process::FileIter file(proc); file; file++)
+			for(File::SegIter seg(file); seg; seg++)
+				if(seg->isExecutable())
+					for(Segment::ItemIter item(seg); item; item++) {
+						Inst *inst = item->toInst();
+						if(inst)
+							for(unsigned i = 0; i < sizeof(ids) / sizeof(ids[0]); i++)
+								inst->removeAllProp(ids[i]);
+					}
+	}
+
+	/**
+	 * Set a configuration property by the name of its identifier.
+	 * @param props		Configuration to set.
+	 * @param name		Identifier name.
+	 * @param value		Value as text.
+	 * @param strict	If true, an unknown identifier is an error, else it is ignored.
+	 */
+	static void set(PropList& props, const string& name, const string& value, bool strict) {
+		AbstractIdentifier *id = AbstractIdentifier::find(name);
+		if(!id)
+			id = ProcessorPlugin::getIdentifier(name.toCString());
+		if(id)
+			id->fromString(props, value);
+		else if(strict)
+			throw otawa::Exception(_ << "unknown identifier " << name);
+	}
+
+	/**
+	 * Compute the Fletcher checksum of a file, as used in flow fact files.
+	 * @param path	File path.
+	 * @return		Checksum.
+	 */
+	static t::uint32 checksum(const string& path) {
+		FILE *f = fopen(path.toCString().chars(), "r");
+		if(!f)
+			throw otawa::Exception(_ << "cannot open " << path);
+		util::Fletcher summer;
+		char buf[1 << 16];
+		size_t n;
+		while((n = fread(buf, 1, sizeof(buf), f)) > 0)
+			summer.write(buf, n);
+		fclose(f);
+		return summer.sum();
+	}
+
+	static t::uint64 now(void) {
+		struct timeval tv;
+		gettimeofday(&tv, 0);
+		return t::uint64(tv.tv_sec) * 1000000 + tv.tv_usec;
+	}
+
+	int max;
+	t::uint64 clock;
+	genstruct::Vector<program_t> progs;
+};
+
+} }	// tcrest::patmos
+
+
+static volatile sig_atomic_t stopped = 0;
+
+static void stop(int sig) {
+	stopped = 1;
+}
+
+int main(int argc, char **argv) {
+	const char *path = PATMOS_WCETD_SOCKET;
+	int max = 4, timeout = 60;
+
+	// parse arguments
+	int opt;
+	while((opt = getopt(argc, argv, "s:n:t:h")) != -1)
+		switch(opt) {
+		case 's':
+			path = optarg;
+			break;
+		case 'n':
+			max = atoi(optarg);
+			break;
+		case 't':
+			timeout = atoi(optarg);
+			break;
+		default:
+			fprintf(stderr, "usage: %s [-s socket] [-n max programs] [-t idle timeout]\n", argv[0]);
+			return opt == 'h' ? 0 : 1;
+		}
+	if(max < 1)
+		max = 1;
+
+	// signals: interrupt the accept on termination
+	struct sigaction sa;
+	memset(&sa, 0, sizeof(sa));
+	sa.sa_handler = stop;
+	sigaction(SIGINT, &sa, 0);
+	sigaction(SIGTERM, &sa, 0);
+	signal(SIGPIPE, SIG_IGN);
+
+	// open the socket
+	struct sockaddr_un addr;
+	if(strlen(path) >= sizeof(addr.sun_path)) {
+		fprintf(stderr, "ERROR: socket path too long: %s\n", path);
+		return 1;
+	}
+	int sock = socket(AF_UNIX, SOCK_STREAM, 0);
+	if(sock < 0) {
+		perror("socket");
+		return 1;
+	}
+	memset(&addr, 0, sizeof(addr));
+	addr.sun_family = AF_UNIX;
+	strcpy(addr.sun_path, path);
+	unlink(path);
+	if(bind(sock, (struct sockaddr *)&addr, sizeof(addr)) < 0 || listen(sock, 8) < 0) {
+		perror(path);
+		close(sock);
+		return 1;
+	}
+
+	// serve the connections
+	tcrest::patmos::Daemon daemon(max);
+	while(!stopped) {
+		int fd = accept(sock, 0, 0);
+		if(fd < 0) {
+			if(errno == EINTR)
+				continue;
+			perror("accept");
+			break;
+		}
+		daemon.serve(fd, timeout);
+	}
+	close(sock);
+	unlink(path);
+	return 0;
+}
@@ -0,0 +1,31 @@
+/*
+ * License HERE!
+ */
+#ifndef TCREST_PATMOS_DAEMON_H
+#define TCREST_PATMOS_DAEMON_H
+
+/*
+ * Protocol of the analysis daemon (patmos-wcetd).
+ *
+ * The daemon listens on a Unix stream socket. A request is a list of
+ * "<key> <value>" lines ended by an empty line:
+ *	elf <path>			absolute path of the ELF file (mandatory),
+ *	checksum <sum>		Fletcher checksum of the ELF file (as in .ff files),
+ *	entry <symbol>		task entry (default to main),
+ *	flowfacts <path>	flow fact file (.ff or .pml),
+ *	script <path>		analysis script (default to patmos_wcet.osx),
+ *	config <id>=<value>	configuration of the analysis (several allowed).
+ * The reply has the same format:
+ *	status ok|error
+ *	wcet <cycles>		computed WCET,
+ *	loaded yes|no		whether the ELF file has been loaded for this request,
+ *	time <ms>			time spent on the request,
+ *	message <text>		error message.
+ * Several requests may be sent on the same connection. The connections are
+ * served one at a time and a connection idle for more than the daemon
+ * timeout (option -t, in seconds) is closed.
+ */
+
+#define PATMOS_WCETD_SOCKET		"/tmp/patmos-wcetd.sock"
+
+#endif	// TCREST_PATMOS_DAEMON_H
@@ -1,86 +1,356 @@
-#include <otawa/proc/EdgeProcessor.h>
+#include <otawa/proc/Processor.h>
 #include <otawa/ilp/features.h>
 #include <otawa/ipet/features.h>
 #include <otawa/ilp/System.h>
 #include <otawa/ilp/Constraint.h>
+#include <otawa/cfg/features.h>
+#include <otawa/hard/Memory.h>
+#include <elm/util/BitVector.h>
+#include "Contexts.h"
 
 namespace tcrest { namespace patmos {
 
 using namespace otawa;
 
-class MethodCacheContributor: public EdgeProcessor {
+extern Identifier<int> METHOD_CACHE_SIZE;
+extern Identifier<int> METHOD_CACHE_BLOCK_SIZE;
+extern Identifier<int> METHOD_CACHE_ENTRIES;
+extern Identifier<string> METHOD_CACHE_POLICY;
+extern Identifier<int> METHOD_CACHE_TRANSFER_SIZE;
+
+/**
+ * Method cache analysis based on persistence scopes.
+ *
+ * The analysis works on the function instances of @ref Contexts: with
+ * virtualized CFGs, each inlined copy of a function is analyzed in its own
+ * calling context.
+ *
+ * A scope (a loop or a whole function instance) is persistent if all the
+ * functions that may be called inside it, plus the function containing it, fit
+ * in the method cache (blocks and entries). Whatever the policy, each of these
+ * functions is then loaded at most once per entry in the scope: one
+ * variable by scope, bounded by the scope entries, supports the load cost
+ * of all its functions. The outermost persistent scope of a call is used.
+ *
+ * Calls outside of any persistent scope cost, at each call, the load of the
+ * callee (unless the callee is itself a persistent scope, that supports it)
+ * and, on return, the reload of the caller. With the LRU policy, the caller is
+ * the most recently used function at the call and the reload is avoided
+ * if the caller and the functions reachable from the callee fit in the cache.
+ * Unless the task is a persistent scope, its entry function is loaded once.
+ */
+class MethodCacheContributor: public Processor {
 public:
 	static p::declare reg;
-	MethodCacheContributor(p::declare& r = reg): EdgeProcessor(r), sys(0), exp(false) { }
+	MethodCacheContributor(p::declare& r = reg): Processor(r), sys(0), exp(false),
+		cache_size(0), block_size(0), entries(0), lru(false), transfer(0), mem(0), ctx(0) { }
 
 protected:
 
 	virtual void configure(const PropList& props) {
-		EdgeProcessor::configure(props);
+		Processor::configure(props);
 		exp = ipet::EXPLICIT(props);
+		cache_size = METHOD_CACHE_SIZE(props);
+		block_size = METHOD_CACHE_BLOCK_SIZE(props);
+		entries = METHOD_CACHE_ENTRIES(props);
+		lru = METHOD_CACHE_POLICY(props) == "LRU";
+		transfer = METHOD_CACHE_TRANSFER_SIZE(props);
+		if(block_size <= 0 || cache_size < block_size || transfer <= 0)
+			throw ProcessorException(*this, "bad method cache configuration");
 	}
 
-	virtual void setup(WorkSpace *ws) {
+	virtual void processWorkSpace(WorkSpace *ws) {
 		sys = ipet::SYSTEM(ws);
+		mem = &ws->platform()->memory();
+		const CFGCollection *coll = INVOLVED_CFGS(ws);
+		ASSERT(coll);
+		ctx = new Contexts(coll, otawa::patmos::INFO(ws->process()));
+
+		// compute the function sizes and load times
+		int nf = ctx->countFunctions();
+		for(int f = 0; f < nf; f++) {
+			blocks.add((ctx->functionSize(f) + block_size - 1) / block_size);
+			times.add(loadTime(ctx->functionAddress(f), ctx->functionSize(f)));
+		}
+
+		// compute the functions reachable from the instances (transitive closure)
+		int n = ctx->count();
+		for(int i = 0; i < n; i++) {
+			reachable.add(new BitVector(nf));
+			reachable[i]->set((*ctx)[i].fun);
+		}
+		bool changed = true;
+		while(changed) {
+			changed = false;
+			for(int i = 0; i < n; i++)
+				for(int j = 0; j < (*ctx)[i].calls.count(); j++) {
+					BitVector v = *reachable[i];
+					v.applyOr(*reachable[(*ctx)[i].calls[j].inst]);
+					if(!v.equals(*reachable[i])) {
+						*reachable[i] = v;
+						changed = true;
+					}
+				}
+		}
+
+		// task entry: persistent scope or single load
+		if(fits(*reachable[0]))
+			record(0, 0, new BitVector(*reachable[0]));
+		else
+			sys->addObjectFunction(double(times[(*ctx)[0].fun]), ctx->entries(0));
+
+		// calls of the instances not persistent as a whole
+		for(int i = 0; i < n; i++)
+			if(!fits(*reachable[i]))
+				for(int j = 0; j < (*ctx)[i].calls.count(); j++)
+					processCall(i, (*ctx)[i].calls[j]);
+
+		// add the variables of the persistent scopes
+		for(int i = 0; i < scopes.count(); i++)
+			addScope(scopes[i]);
+
+		// release the analysis data
+		for(int i = 0; i < reachable.count(); i++)
+			delete reachable[i];
+		reachable.clear();
+		for(int i = 0; i < scopes.count(); i++)
+			delete scopes[i].members;
+		scopes.clear();
+		blocks.clear();
+		times.clear();
+		delete ctx;
+		ctx = 0;
 	}
 
-	virtual void processEdge(WorkSpace *ws, CFG *cfg, Edge *edge) {
-		if(!doesMethodLoad(edge))
+private:
+
+	typedef struct scope_t {
+		int inst;
+		BasicBlock *header;		// null for a function scope
+		BitVector *members;
+	} scope_t;
+
+	/**
+	 * Add the cost of a call of an instance not persistent as a whole.
+	 * @param i		Caller instance.
+	 * @param call	Processed call.
+	 */
+	void processCall(int i, const Contexts::call_t& call) {
+		if(inScope(i, call))
 			return;
 
+		// callee load, supported by the callee scope if persistent
+		ot::time time = 0;
+		const Contexts::instance_t& callee = (*ctx)[call.inst];
+		if(fits(*reachable[call.inst]))
+			record(call.inst, 0, new BitVector(*reachable[call.inst]));
+		else
+			time += times[callee.fun];
+
+		// caller reload on return
+		BitVector v = *reachable[call.inst];
+		v.set((*ctx)[i].fun);
+		if(!lru || !fits(v))
+			time += times[(*ctx)[i].fun];
+
 		// x_f -- number of method load
 		// c_f -- cost of load
-		// x_f^h -- head block controlling the number of load (typically a loop header entry edge)
-		// x_e -- number of time the edge is taken (performing the call)
-
-		// make the variables x_f
+		// x_c -- number of times the call is performed
 		string name;
 		if(exp)
-			name = _ << "x_mc_" << cfg->label() << "_" << edge->source()->number() << "_" << edge->target()->number();
+			name = _ << "x_mc_" << (*ctx)[i].name << "_" << call.edge->source()->number() << "_" << callee.name;
 		ilp::Var *x_f = sys->newVar(name);
 
-		// x_f <= x_f^h		(bounding by the controlling header)
-		ilp::Constraint *c1 = sys->newConstraint("method cache control", ilp::Constraint::LE);
-		c1->addLeft(1, x_f);
-		c1->addRight(1, loadVar(edge));
-
-		// x_f <= x_e
-		ilp::Constraint *c2 = sys->newConstraint("method cache edge", ilp::Constraint::LE);
-		c1->addLeft(1, x_f);
-		c1->addRight(1, ipet::VAR(edge));
+		// x_f <= x_c
+		ilp::Constraint *c = sys->newConstraint("method cache call", ilp::Constraint::LE);
+		c->addLeft(1, x_f);
+		c->addRight(1, Contexts::calls(call.edge));
 
 		// wcet += c_f x_f		add contribution to the WCET
-		sys->addObjectFunction(double(loadTime(edge)), x_f);
+		sys->addObjectFunction(double(time), x_f);
 	}
 
-private:
+	/**
+	 * Test if a call is covered by a persistent loop scope of its instance.
+	 * The persistent scope of the call, if any, is recorded.
+	 * @param i		Caller instance.
+	 * @param call	Tested call.
+	 * @return		True if the call is covered.
+	 */
+	bool inScope(int i, const Contexts::call_t& call) {
 
-	bool doesMethodLoad(Edge *edge) {
-		// TODO do the job here
+		// enclosing loops of the instance, from the outermost to the innermost
+		// (with virtualized CFGs, the loops of the callers enclose the instance)
+		const Contexts::instance_t& inst = (*ctx)[i];
+		genstruct::Vector<BasicBlock *> loops;
+		BasicBlock *bb = call.edge->source();
+		for(BasicBlock *h = LOOP_HEADER(bb) ? bb : ENCLOSING_LOOP_HEADER(bb); h; h = ENCLOSING_LOOP_HEADER(h))
+			if(ctx->owner(inst.cfg, h) == i)
+				loops.add(h);
+		for(int j = loops.count() - 1; j >= 0; j--) {
+			BitVector *members = loopMembers(i, loops[j]);
+			if(fits(*members)) {
+				record(i, loops[j], members);
+				return true;
+			}
+			delete members;
+		}
 		return false;
 	}
 
-	ot::time loadTime(Edge *edge) {
-		// TODO compute the load time here
-		return 0;
+	/**
+	 * Compute the time to load a function.
+	 * @param addr	Function address.
+	 * @param size	Function size (in bytes).
+	 * @return		Load time.
+	 */
+	ot::time loadTime(Address addr, ot::size size) {
+		const hard::Bank *bank = mem->get(addr);
+		int latency = bank ? bank->latency() : 1;
+		ot::size bsize = ((size + block_size - 1) / block_size) * block_size;
+		return ot::time((bsize + transfer - 1) / transfer) * latency;
+	}
+
+	/**
+	 * Compute the functions reachable from the calls of a loop.
+	 * @param i			Current instance.
+	 * @param header	Loop header.
+	 * @return			Set of functions (including the current one).
+	 */
+	BitVector *loopMembers(int i, BasicBlock *header) {
+		const Contexts::instance_t& inst = (*ctx)[i];
+		BitVector *members = new BitVector(times.count());
+		members->set(inst.fun);
+		for(int j = 0; j < inst.calls.count(); j++)
+			if(inLoop(inst.calls[j].edge->source(), header))
+				members->applyOr(*reachable[inst.calls[j].inst]);
+		return members;
 	}
 
-	ilp::Var *loadVar(Edge *edge) {
-		// TODO variable to be dependent on (possibly null)
-		return 0;
+	static bool inLoop(BasicBlock *bb, BasicBlock *header) {
+		for(BasicBlock *h = LOOP_HEADER(bb) ? bb : ENCLOSING_LOOP_HEADER(bb); h; h = ENCLOSING_LOOP_HEADER(h))
+			if(h == header)
+				return true;
+		return false;
+	}
+
+	/**
+	 * Test if a set of functions fits in the method cache.
+	 * @param set	Set of functions.
+	 * @return		True if it fits, false else.
+	 */
+	bool fits(const BitVector& set) {
+		int cnt = 0, size = 0;
+		for(BitVector::OneIterator i(set); i; i++) {
+			cnt++;
+			size += blocks[*i];
+		}
+		return cnt <= entries && size * block_size <= cache_size;
+	}
+
+	/**
+	 * Record a persistent scope (if not already recorded).
+	 * @param inst		Scope instance.
+	 * @param header	Scope loop header (null for the whole instance).
+	 * @param members	Functions of the scope (released if already recorded).
+	 */
+	void record(int inst, BasicBlock *header, BitVector *members) {
+		for(int i = 0; i < scopes.count(); i++)
+			if(scopes[i].inst == inst && scopes[i].header == header) {
+				delete members;
+				return;
+			}
+		scope_t scope;
+		scope.inst = inst;
+		scope.header = header;
+		scope.members = members;
+		scopes.add(scope);
+	}
+
+	/**
+	 * Add to the ILP system the load variable of a persistent scope:
+	 * x_s <= sum of entries in s
+	 * wcet += (sum of load times of the scope functions) x_s
+	 * @param scope		Scope to add.
+	 */
+	void addScope(const scope_t& scope) {
+		string name;
+		if(exp) {
+			if(scope.header)
+				name = _ << "x_mc_" << (*ctx)[scope.inst].name << "_loop_" << scope.header->number();
+			else
+				name = _ << "x_mc_" << (*ctx)[scope.inst].name;
+		}
+		ilp::Var *x_s = sys->newVar(name);
+		ilp::Constraint *c = sys->newConstraint("method cache scope", ilp::Constraint::LE);
+		c->addLeft(1, x_s);
+		if(!scope.header)
+			c->addRight(1, ctx->entries(scope.inst));
+		else
+			for(BasicBlock::InIterator edge(scope.header); edge; edge++)
+				if(!BACK_EDGE(edge))
+					c->addRight(1, ipet::VAR(edge));
+		ot::time time = 0;
+		for(BitVector::OneIterator i(*scope.members); i; i++)
+			time += times[*i];
+		sys->addObjectFunction(double(time), x_s);
 	}
 
 	ilp::System *sys;
 	bool exp;
+	int cache_size, block_size, entries;
+	bool lru;
+	int transfer;
+	const hard::Memory *mem;
+	Contexts *ctx;
+	genstruct::Vector<int> blocks;
+	genstruct::Vector<ot::time> times;
+	genstruct::Vector<BitVector *> reachable;
+	genstruct::Vector<scope_t> scopes;
 };
 
 p::feature METHOD_CACHE_CONTRIBUTION_FEATURE("tcrest::patmos::METHOD_CACHE_CONTRIBUTION_FEATURE", new Maker<MethodCacheContributor>());
 
 p::declare MethodCacheContributor::reg = p::init("tcrest::patmos::MethodCacheContributor", Version(1, 0, 0))
-	.base(EdgeProcessor::reg)
+	.base(Processor::reg)
 	.maker<MethodCacheContributor>()
 	.require(ipet::ILP_SYSTEM_FEATURE)
 	.require(ipet::ASSIGNED_VARS_FEATURE)
+	.require(COLLECTED_CFG_FEATURE)
+	.require(LOOP_HEADERS_FEATURE)
+	.require(LOOP_INFO_FEATURE)
 	.provide(METHOD_CACHE_CONTRIBUTION_FEATURE);
 
+
+/**
+ * Size of the method cache in bytes (default to 4096).
+ */
+Identifier<int> METHOD_CACHE_SIZE("tcrest::patmos::METHOD_CACHE_SIZE", 4096);
+
+
+/**
+ * Size of the blocks of the method cache in bytes (default to 32).
+ * Functions are allocated in the method cache as a whole number of blocks.
+ */
+Identifier<int> METHOD_CACHE_BLOCK_SIZE("tcrest::patmos::METHOD_CACHE_BLOCK_SIZE", 32);
+
+
+/**
+ * Maximum number of functions in the method cache (default to 16).
+ */
+Identifier<int> METHOD_CACHE_ENTRIES("tcrest::patmos::METHOD_CACHE_ENTRIES", 16);
+
+
+/**
+ * Replacement policy of the method cache, one of "FIFO" (default) or "LRU".
+ */
+Identifier<string> METHOD_CACHE_POLICY("tcrest::patmos::METHOD_CACHE_POLICY", "FIFO");
+
+
+/**
+ * Size in bytes of a memory transfer when a function is loaded (default to 16).
+ * Each transfer costs the latency of the memory bank containing the function.
+ */
+Identifier<int> METHOD_CACHE_TRANSFER_SIZE("tcrest::patmos::METHOD_CACHE_TRANSFER_SIZE", 16);
+
 } }	// tcrest::patmos
@@ -0,0 +1,331 @@
+/*
+ * License HERE!
+ */
+
+#include <otawa/proc/Processor.h>
+#include <otawa/prog/WorkSpace.h>
+#include <otawa/ipet/features.h>
+#include <otawa/ilp/System.h>
+#include <otawa/cfg/features.h>
+#include "ArchiveStream.h"
+#include <algorithm>
+
+namespace tcrest { namespace patmos {
+
+using namespace otawa;
+
+extern Identifier<sys::Path> PML_OUTPUT;
+extern Identifier<ot::time> CACHE_TIME;
+
+/**
+ * Exporter of the WCET results as a PML timing section.
+ *
+ * The blocks are named as in the PML of the compiler, by their machine
+ * function and machine block numbers, found from the ".LBB<function>_<block>"
+ * symbols. A block split by OTAWA (after a call) is referenced by its machine
+ * block and the index of its first instruction: the time of the edge entering
+ * it from the same machine block is folded into its contribution. Blocks
+ * outside of machine functions are skipped. With virtualized CFGs, the copies
+ * of a block in the different calling contexts are merged in one reference.
+ *
+ * The profile has an entry for each block (worst time, WCET frequency and
+ * contribution, and the worst cache time added to the block, if any) and for
+ * each edge (worst time delta, frequency and contribution, and cache time).
+ * The cache cycles of the scope are the part of the WCET not supported by
+ * the blocks and edges, nor by their cache times.
+ *
+ * The document is written to the file through a big stdio buffer.
+ *
+ * @p Configuration
+ * @li @ref PML_OUTPUT
+ */
+class PMLExporter: public Processor {
+public:
+	static p::declare reg;
+	PMLExporter(p::declare& r = reg): Processor(r), proc(0), sys(0), skipped(0) { }
+
+protected:
+
+	virtual void configure(const PropList& props) {
+		Processor::configure(props);
+		path = PML_OUTPUT(props);
+	}
+
+	virtual void processWorkSpace(WorkSpace *ws) {
+		const CFGCollection *coll = INVOLVED_CFGS(ws);
+		ASSERT(coll);
+		proc = ws->process();
+		sys = ipet::SYSTEM(ws);
+		skipped = 0;
+		collect();
+
+		// open the output
+		sys::Path p = path;
+		if(p.toString().isEmpty())
+			p = sys::Path(proc->program()->name()).setExtension("wcet.pml");
+		FILE *file = fopen(p.toString().toCString().chars(), "w");
+		if(!file)
+			throw ProcessorException(*this, _ << "cannot create PML output " << p);
+		ArchiveStream stream(file);
+		io::Output out(stream);
+
+		// cycles not supported by blocks, edges and their cache times
+		ot::time wcet = ipet::WCET(ws), base = 0;
+		for(int i = 0; i < coll->count(); i++)
+			for(CFG::BBIterator bb(coll->get(i)); bb; bb++) {
+				base += (time(bb) + CACHE_TIME(bb)) * count(ipet::VAR(bb));
+				for(BasicBlock::OutIterator edge(bb); edge; edge++)
+					if(edge->kind() != Edge::CALL)
+						base += (ipet::TIME_DELTA(edge) + CACHE_TIME(edge)) * count(ipet::VAR(edge));
+			}
+
+		// merge the references by machine block
+		for(int i = 0; i < coll->count(); i++)
+			for(CFG::BBIterator bb(coll->get(i)); bb; bb++)
+				if(!bb->isEnd()) {
+					addBlock(bb);
+					for(BasicBlock::OutIterator edge(bb); edge; edge++)
+						addEdge(edge);
+				}
+		if(!refs.isEmpty())
+			std::sort(&refs[0], &refs[0] + refs.count(), before);
+		int n = 0;
+		for(int i = 0; i < refs.count(); i++)
+			if(n && same(refs[n - 1], refs[i]))
+				merge(refs[n - 1], refs[i]);
+			else
+				refs[n++] = refs[i];
+
+		// header
+		CFG *task = coll->get(0);
+		int e = find(task->address());
+		out << "---\n"
+			<< "format: pml-0.1\n"
+			<< "triple: patmos-unknown-unknown-elf\n"
+			<< "timing:\n"
+			<< "- scope:\n"
+			<< "    function: " << (e >= 0 ? syms[e].fun : String(task->label())) << "\n"
+			<< "  cycles: " << wcet << "\n"
+			<< "  level: machinecode\n"
+			<< "  origin: otawa\n"
+			<< "  cache-cycles: " << (wcet - base) << "\n"
+			<< "  profile:\n";
+
+		// profile
+		for(int i = 0; i < n; i++)
+			write(out, refs[i]);
+		out << "...\n";
+		out.flush();
+
+		if(logFor(LOG_DEPS))
+			log << "\t" << n << " references written to " << p << ", " << skipped << " blocks skipped" << io::endl;
+		syms.clear();
+		funs.clear();
+		refs.clear();
+	}
+
+private:
+	typedef struct {
+		t::uint32 addr;
+		String fun, block;
+	} entry_t;
+
+	typedef struct {
+		bool edge;
+		int src, tgt;			// machine blocks (tgt: -1 for an edge to the end)
+		t::uint32 addr;			// first instruction of a block
+		ot::time cycles, cache, contrib;
+		int freq;
+	} ref_t;
+
+	static bool less(const entry_t& e1, const entry_t& e2) { return e1.addr < e2.addr; }
+
+	static bool same(const ref_t& r1, const ref_t& r2)
+		{ return r1.edge == r2.edge && r1.src == r2.src && r1.tgt == r2.tgt && r1.addr == r2.addr; }
+
+	static bool before(const ref_t& r1, const ref_t& r2) {
+		if(r1.src != r2.src)
+			return r1.src < r2.src;
+		if(r1.edge != r2.edge)
+			return !r1.edge;
+		if(r1.tgt != r2.tgt)
+			return r1.tgt < r2.tgt;
+		return r1.addr < r2.addr;
+	}
+
+	static void merge(ref_t& r, const ref_t& o) {
+		r.cycles = max(r.cycles, o.cycles);
+		r.cache = max(r.cache, o.cache);
+		r.contrib += o.contrib;
+		r.freq += o.freq;
+	}
+
+	/**
+	 * Collect the machine block and the function symbols sorted by address.
+	 */
+	void collect(void) {
+		syms.clear();
+		funs.clear();
+		for(File::SymIter sym(proc->program()); sym; sym++) {
+			if(sym->kind() == Symbol::FUNCTION)
+				funs.add(sym->address().offset());
+			const String& n = sym->name();
+			if(!n.startsWith(".LBB"))
+				continue;
+			int u = n.indexOf('_');
+			if(u < 0)
+				continue;
+			entry_t e = { sym->address().offset(), n.substring(4, u - 4), n.substring(u + 1) };
+			syms.add(e);
+		}
+		if(!syms.isEmpty())
+			std::sort(&syms[0], &syms[0] + syms.count(), less);
+		if(!funs.isEmpty())
+			std::sort(&funs[0], &funs[0] + funs.count());
+	}
+
+	/**
+	 * Find the machine block containing the given address: the closest
+	 * machine block symbol below the address, if no function starts between
+	 * them.
+	 * @param addr	Looked address.
+	 * @return		Machine block index or -1.
+	 */
+	int find(const Address& addr) {
+		int l = 0, h = syms.count();
+		while(l < h) {
+			int m = (l + h) / 2;
+			if(syms[m].addr <= addr.offset())
+				l = m + 1;
+			else
+				h = m;
+		}
+		if(l == 0)
+			return -1;
+		if(!funs.isEmpty()) {
+			const t::uint32 *f = std::upper_bound(&funs[0], &funs[0] + funs.count(), addr.offset());
+			if(f != &funs[0] && f[-1] > syms[l - 1].addr)
+				return -1;
+		}
+		return l - 1;
+	}
+
+	inline int count(ilp::Var *var) { return var ? int(sys->valueOf(var) + .5) : 0; }
+	inline ot::time time(BasicBlock *bb) { return bb->isEnd() ? 0 : max(ot::time(0), ot::time(ipet::TIME(bb))); }
+
+	/**
+	 * Test if an edge is internal to a machine block, that is, it enters
+	 * a block split by OTAWA.
+	 */
+	bool internal(Edge *edge) {
+		if(edge->kind() == Edge::CALL || edge->target()->isEnd())
+			return false;
+		int e = find(edge->target()->address());
+		return e >= 0 && syms[e].addr != edge->target()->address().offset();
+	}
+
+	void addBlock(BasicBlock *bb) {
+		int e = find(bb->address());
+		if(e < 0) {
+			skipped++;
+			return;
+		}
+		ref_t r = { false, e, -1, bb->address().offset(), time(bb), CACHE_TIME(bb), 0, count(ipet::VAR(bb)) };
+		r.contrib = r.cycles * r.freq;
+		for(BasicBlock::InIterator edge(bb); edge; edge++)
+			if(!edge->source()->isEnd() && internal(edge))
+				r.contrib += ipet::TIME_DELTA(edge) * count(ipet::VAR(edge));
+		refs.add(r);
+	}
+
+	void addEdge(Edge *edge) {
+		if(edge->kind() == Edge::CALL || internal(edge))
+			return;
+		int src = find(edge->source()->address()), tgt = -1;
+		if(src < 0)
+			return;
+		if(!edge->target()->isEnd()) {
+			tgt = find(edge->target()->address());
+			if(tgt < 0)
+				return;
+		}
+		ref_t r = { true, src, tgt, 0, ot::time(ipet::TIME_DELTA(edge)), CACHE_TIME(edge), 0, count(ipet::VAR(edge)) };
+		r.contrib = r.cycles * r.freq;
+		refs.add(r);
+	}
+
+	void write(io::Output& out, const ref_t& r) {
+		const entry_t& src = syms[r.src];
+		out << "  - reference:\n"
+			<< "      function: " << src.fun << "\n";
+		if(!r.edge) {
+			out << "      block: " << src.block << "\n";
+			if(src.addr != r.addr)
+				out << "      instruction: " << index(src, Address(r.addr)) << "\n";
+		}
+		else {
+			out << "      edgesource: " << src.block << "\n";
+			if(r.tgt >= 0)
+				out << "      edgetarget: " << syms[r.tgt].block << "\n";
+		}
+		out << "    cycles: " << r.cycles << "\n"
+			<< "    wcet-frequency: " << r.freq << "\n"
+			<< "    wcet-contribution: " << r.contrib << "\n";
+		if(r.cache)
+			out << "    cache-cycles: " << r.cache << "\n";
+	}
+
+	/**
+	 * Compute the index of the first instruction of a block split by OTAWA
+	 * in its machine block.
+	 */
+	int index(const entry_t& e, const Address& addr) {
+		int i = 0;
+		for(Inst *inst = proc->findInstAt(Address(e.addr)); inst && inst->address() < addr; inst = inst->nextInst())
+			i++;
+		return i;
+	}
+
+	sys::Path path;
+	Process *proc;
+	ilp::System *sys;
+	genstruct::Vector<entry_t> syms;
+	genstruct::Vector<t::uint32> funs;
+	genstruct::Vector<ref_t> refs;
+	int skipped;
+};
+
+
+/**
+ * Feature ensuring that the WCET results have been written as a PML timing section.
+ */
+p::feature PML_OUTPUT_FEATURE("tcrest::patmos::PML_OUTPUT_FEATURE", new Maker<PMLExporter>());
+
+p::declare PMLExporter::reg = p::init("tcrest::patmos::PMLExporter", Version(1, 0, 0))
+	.base(Processor::reg)
+	.maker<PMLExporter>()
+	.require(COLLECTED_CFG_FEATURE)
+	.require(ipet::ASSIGNED_VARS_FEATURE)
+	.require(ipet::WCET_FEATURE)
+	.provide(PML_OUTPUT_FEATURE);
+
+
+/**
+ * Path of the PML file the WCET results are written to (default to the path
+ * of the program with the extension ".wcet.pml").
+ */
+Identifier<sys::Path> PML_OUTPUT("tcrest::patmos::PML_OUTPUT", "");
+
+
+/**
+ * Cache time added to the objective function for each execution of a block
+ * or each traversal of an edge (stack cache spills and fills, uncached data
+ * accesses).
+ *
+ * @p Hooks
+ * @li BasicBlock
+ * @li Edge
+ */
+Identifier<ot::time> CACHE_TIME("tcrest::patmos::CACHE_TIME", 0);
+
+} }	// tcrest::patmos
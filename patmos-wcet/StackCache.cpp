@@ -0,0 +1,308 @@
+/*
+ * License HERE!
+ */
+
+#include <otawa/proc/Processor.h>
+#include <otawa/ilp/features.h>
+#include <otawa/ipet/features.h>
+#include <otawa/ilp/System.h>
+#include <otawa/cfg/features.h>
+#include <otawa/hard/Memory.h>
+#include "../otawa-patmos/patmos.h"
+#include "Contexts.h"
+
+namespace tcrest { namespace patmos {
+
+using namespace otawa;
+
+extern Identifier<int> STACK_CACHE_SIZE;
+extern Identifier<int> STACK_CACHE_TRANSFER_SIZE;
+extern Identifier<ot::time> CACHE_TIME;
+
+/**
+ * Stack cache analysis.
+ *
+ * The analysis works on the function instances of @ref Contexts: with
+ * virtualized CFGs, each inlined copy of a function is analyzed in its own
+ * calling context. Each instance is summarized by its reserved frame (the
+ * greatest sres of the function) and its displacement, the maximal occupancy
+ * of the stack cache by the instance and its callees (computed bottom-up on
+ * the call graph). The occupancy at each call and the worst-case occupancy at
+ * entry of each instance are then computed top-down.
+ *
+ * With SIZE the stack cache size, the costs added to the IPET objective are:
+ *	- sres n in f:		spill of min(n, max(0, entry + n - SIZE)) bytes,
+ *	- sens n after a call to g:	fill of min(n, max(0, n + displacement(g) - SIZE)) bytes,
+ *	- sspill n:			spill of n bytes.
+ * The fill of a sens is charged on each edge entering its block with the
+ * displacement of the callee returning by this edge (the whole stack cache
+ * if the edge does not return from a call). The spill of a sres outside of
+ * loops of a CFG shared by several calls is charged on each call with the
+ * occupancy at this call; else it is charged on the block with the entry
+ * occupancy of the instance. Amounts given by a register are considered as
+ * the whole stack cache.
+ */
+class StackCacheAnalysis: public Processor {
+public:
+	static p::declare reg;
+	StackCacheAnalysis(p::declare& r = reg): Processor(r), size(0), transfer(0), latency(1), info(0), sys(0), ctx(0) { }
+
+protected:
+
+	virtual void configure(const PropList& props) {
+		Processor::configure(props);
+		size = STACK_CACHE_SIZE(props);
+		transfer = STACK_CACHE_TRANSFER_SIZE(props);
+		if(size <= 0 || transfer <= 0)
+			throw ProcessorException(*this, "bad stack cache configuration");
+	}
+
+	virtual void processWorkSpace(WorkSpace *ws) {
+		info = otawa::patmos::INFO(ws->process());
+		ASSERT(info);
+		const CFGCollection *coll = INVOLVED_CFGS(ws);
+		ASSERT(coll);
+		ctx = new Contexts(coll);
+		int n = ctx->count();
+
+		// memory latency: worst bank
+		latency = 1;
+		const hard::Memory& mem = ws->platform()->memory();
+		for(int i = 0; i < mem.banks().count(); i++)
+			latency = max(latency, int(mem.banks()[i]->latency()));
+
+		// local summaries
+		for(int i = 0; i < n; i++) {
+			frames.add(frame(i));
+			displacements.add(0);
+			entries.add(0);
+			states.add(TODO);
+		}
+
+		// displacements (bottom-up)
+		genstruct::Vector<int> order;
+		for(int i = 0; i < n; i++)
+			if(states[i] == TODO)
+				displace(i, order);
+
+		// entry occupancies (top-down, callers before callees)
+		for(int k = order.count() - 1; k >= 0; k--) {
+			int i = order[k];
+			for(int j = 0; j < (*ctx)[i].calls.count(); j++) {
+				int callee = (*ctx)[i].calls[j].inst;
+				if(states[callee] == RECURSIVE)
+					entries[callee] = size;
+				else
+					entries[callee] = max(entries[callee], occupancy(i));
+			}
+		}
+		if(logFor(LOG_FUN))
+			for(int i = 0; i < n; i++)
+				log << "\t" << (*ctx)[i].name << ": frame = " << frames[i]
+					<< ", displacement = " << displacements[i] << ", entry = " << entries[i] << io::endl;
+
+		// add the costs
+		sys = ipet::SYSTEM(ws);
+		for(int i = 0; i < n; i++)
+			for(int j = 0; j < (*ctx)[i].bbs.count(); j++)
+				contribute(i, (*ctx)[i].bbs[j]);
+
+		frames.clear();
+		displacements.clear();
+		entries.clear();
+		states.clear();
+		delete ctx;
+		ctx = 0;
+	}
+
+private:
+	typedef enum {
+		TODO = 0,
+		ACTIVE = 1,
+		DONE = 2,
+		RECURSIVE = 3
+	} state_t;
+
+	/**
+	 * Compute the reserved frame of an instance.
+	 * @param i		Instance number.
+	 * @return		Reserved bytes.
+	 */
+	int frame(int i) {
+		int res = 0;
+		const Contexts::instance_t& inst = (*ctx)[i];
+		for(int j = 0; j < inst.bbs.count(); j++)
+			for(BasicBlock::InstIterator ins(inst.bbs[j]); ins; ins++)
+				if(info->stackKind(ins) == otawa::patmos::STACK_RES)
+					res = max(res, amount(ins));
+		return res;
+	}
+
+	/**
+	 * Compute the displacement of an instance (and its callees),
+	 * in depth-first post-order, the instances are added to the order.
+	 * @param i		Instance number.
+	 * @param order	Post-order of the instances.
+	 */
+	void displace(int i, genstruct::Vector<int>& order) {
+		states[i] = ACTIVE;
+		int d = 0;
+		for(int k = 0; k < (*ctx)[i].calls.count(); k++) {
+			int j = (*ctx)[i].calls[k].inst;
+			if(states[j] == TODO)
+				displace(j, order);
+			if(states[j] == ACTIVE || states[j] == RECURSIVE) {
+				states[j] = RECURSIVE;
+				d = size;
+			}
+			else
+				d = max(d, displacements[j]);
+		}
+		displacements[i] = min(size, frames[i] + d);
+		if(states[i] == ACTIVE)
+			states[i] = DONE;
+		order.add(i);
+	}
+
+	/**
+	 * Get the worst-case occupancy of the stack cache at the calls of an instance.
+	 */
+	inline int occupancy(int i) { return min(size, entries[i] + frames[i]); }
+
+	/**
+	 * Add the stack cache costs of a block to the objective function.
+	 * @param i		Current instance.
+	 * @param bb	Current block.
+	 */
+	void contribute(int i, BasicBlock *bb) {
+		const Contexts::instance_t& inst = (*ctx)[i];
+		bool per_call = !inst.call && i != 0 && !inst.callers.isEmpty() && states[i] != RECURSIVE
+			&& !LOOP_HEADER(bb) && !ENCLOSING_LOOP_HEADER(bb);
+		int bytes = 0;
+		genstruct::Vector<int> fills, spills;
+		for(BasicBlock::InIterator edge(bb); edge; edge++)
+			fills.add(0);
+		for(int j = 0; j < inst.callers.count(); j++)
+			spills.add(0);
+
+		for(BasicBlock::InstIterator ins(bb); ins; ins++)
+			switch(info->stackKind(ins)) {
+			case otawa::patmos::STACK_RES: {
+					int n = amount(ins);
+					if(!per_call)
+						bytes += min(n, max(0, entries[i] + n - size));
+					else
+						for(int j = 0; j < inst.callers.count(); j++)
+							spills[j] += min(n, max(0, occupancy(inst.callers[j].inst) + n - size));
+				}
+				break;
+			case otawa::patmos::STACK_ENS: {
+					int n = amount(ins), j = 0;
+					for(BasicBlock::InIterator edge(bb); edge; edge++, j++)
+						fills[j] += min(n, max(0, n + returnDisplacement(inst.cfg, edge) - size));
+				}
+				break;
+			case otawa::patmos::STACK_SPILL:
+				bytes += amount(ins);
+				break;
+			default:
+				break;
+			}
+
+		charge(ipet::VAR(bb), bb, bytes, bb);
+		int j = 0;
+		for(BasicBlock::InIterator edge(bb); edge; edge++, j++)
+			charge(ipet::VAR(edge), edge, fills[j], bb);
+		for(j = 0; j < inst.callers.count(); j++) {
+			Edge *call = inst.callers[j].edge;
+			if(call->kind() == Edge::CALL)
+				charge(Contexts::calls(call), call->source(), spills[j], bb);
+			else
+				charge(Contexts::calls(call), call, spills[j], bb);
+		}
+	}
+
+	/**
+	 * Add the cost of spilled or filled bytes to the objective function.
+	 * @param var	Variable counting the spills or fills.
+	 * @param hook	Block or edge supporting the variable.
+	 * @param bytes	Spilled or filled bytes.
+	 * @param bb	Block containing the stack control instructions.
+	 */
+	void charge(ilp::Var *var, PropList *hook, int bytes, BasicBlock *bb) {
+		if(!bytes)
+			return;
+		ot::time cost = ot::time((bytes + transfer - 1) / transfer) * latency;
+		if(logFor(LOG_BB))
+			log << "\t\t" << bb << ": " << bytes << " bytes spilled/filled, cost = " << cost << io::endl;
+		sys->addObjectFunction(double(cost), var);
+		CACHE_TIME(hook) = CACHE_TIME(hook) + cost;
+	}
+
+	/**
+	 * Get the displacement of the callee returning through an edge:
+	 * the inlined copy for a VIRTUAL_RETURN edge, the callees of the source
+	 * block else. If the edge does not return from a call, the whole
+	 * stack cache is assumed.
+	 * @param cfg	Current CFG.
+	 * @param edge	Edge entering the block of a sens.
+	 * @return		Displacement.
+	 */
+	int returnDisplacement(CFG *cfg, Edge *edge) {
+		int k = ctx->owner(cfg, edge->source());
+		if(k < 0 || edge->kind() == Edge::CALL || edge->kind() == Edge::VIRTUAL_CALL)
+			return size;
+		if(edge->kind() == Edge::VIRTUAL_RETURN)
+			return displacements[k];
+		int d = -1;
+		const Contexts::instance_t& inst = (*ctx)[k];
+		for(int j = 0; j < inst.calls.count(); j++)
+			if(inst.calls[j].edge->source() == edge->source())
+				d = max(d, displacements[inst.calls[j].inst]);
+		return d < 0 ? size : d;
+	}
+
+	inline int amount(Inst *inst) {
+		int n = info->stackAmount(inst);
+		return n < 0 || n > size ? size : n;
+	}
+
+	int size, transfer, latency;
+	otawa::patmos::Info *info;
+	ilp::System *sys;
+	Contexts *ctx;
+	genstruct::Vector<int> frames, displacements, entries;
+	genstruct::Vector<state_t> states;
+};
+
+
+/**
+ * Feature ensuring that the spill and fill costs of the stack cache
+ * have been added to the IPET objective function.
+ */
+p::feature STACK_CACHE_FEATURE("tcrest::patmos::STACK_CACHE_FEATURE", new Maker<StackCacheAnalysis>());
+
+p::declare StackCacheAnalysis::reg = p::init("tcrest::patmos::StackCacheAnalysis", Version(1, 0, 0))
+	.base(Processor::reg)
+	.maker<StackCacheAnalysis>()
+	.require(COLLECTED_CFG_FEATURE)
+	.require(ipet::ILP_SYSTEM_FEATURE)
+	.require(ipet::ASSIGNED_VARS_FEATURE)
+	.require(LOOP_HEADERS_FEATURE)
+	.require(LOOP_INFO_FEATURE)
+	.provide(STACK_CACHE_FEATURE);
+
+
+/**
+ * Size of the stack cache in bytes (default to 2048).
+ */
+Identifier<int> STACK_CACHE_SIZE("tcrest::patmos::STACK_CACHE_SIZE", 2048);
+
+
+/**
+ * Size in bytes of a memory transfer when the stack cache is spilled or filled
+ * (default to 16). Each transfer costs the worst latency of the memory banks.
+ */
+Identifier<int> STACK_CACHE_TRANSFER_SIZE("tcrest::patmos::STACK_CACHE_TRANSFER_SIZE", 16);
+
+} }	// tcrest::patmos